@@ -0,0 +1,113 @@
+// NatLang
+// -- An English parser with an extensible grammar
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GRAMMAR_PROFILE_H_
+#define GRAMMAR_PROFILE_H_
+
+#include "XLangType.h" // uint32_t
+#include <vector> // std::vector
+#include <map> // std::map
+#include <mutex> // std::mutex
+#include <iostream> // std::ostream
+#include <stddef.h> // size_t
+
+// what the grammar did over many parses: shifts per token, reductions per
+// rule, and where failed paths died. Work done on paths that failed is
+// counted apart, since that is what extending the grammar makes worse
+class GrammarProfile
+{
+public:
+    typedef int              rule_t;     // bison's rule number
+    typedef std::vector<int> rule_rhs_t; // bison's symbol numbers of a rule's right-hand side
+
+    // counts of a single parse, kept by the parser that makes them
+    class ParseCounts
+    {
+    public:
+        ParseCounts()
+            : m_lookahead(0), m_rejected(false), m_error_recovery_count(0)
+        {}
+        // a token read by the parser is shifted unless it is rejected, which is
+        // only known once the next one is read
+        void record_token(uint32_t lexer_id)
+        {
+            if(m_rejected)
+                return;
+            if(m_lookahead)
+                m_shifts[m_lookahead]++;
+            m_lookahead = lexer_id;
+        }
+        void record_syntax_error()
+        {
+            m_rejected = true;
+        }
+        // true the first time the rule is counted in this parse, when the
+        // parser is to record its right-hand side
+        bool record_reduction(rule_t rule)
+        {
+            return !m_rejected && ++m_reductions[rule] == 1;
+        }
+        void record_rule_rhs(rule_t rule, const rule_rhs_t &rhs)
+        {
+            m_rule_rhs[rule] = rhs;
+        }
+        void record_error_recovery()
+        {
+            m_error_recovery_count++;
+        }
+
+    private:
+        std::map<uint32_t, size_t>   m_shifts;
+        std::map<rule_t, size_t>     m_reductions;
+        std::map<rule_t, rule_rhs_t> m_rule_rhs; // names the rules in m_reductions
+        uint32_t                     m_lookahead;
+        bool                         m_rejected;
+        size_t                       m_error_recovery_count;
+
+        friend class GrammarProfile;
+    };
+
+    GrammarProfile()
+        : m_parse_count(0), m_accept_count(0), m_error_recovery_count(0)
+    {}
+    // adds the counts of one parse of a path; error_word_index is where it
+    // failed, or -1 if it did not fail on a syntax error. Safe to call from
+    // any number of threads
+    void add_parse(const ParseCounts &counts, const std::vector<uint32_t> &pos_lexer_id_path, bool accepted,
+            int error_word_index);
+    // tables sorted by cost, most expensive first
+    void print_report(std::ostream &os);
+
+private:
+    typedef struct
+    {
+        size_t m_total;
+        size_t m_failed; // on paths that did not parse
+    } count_t;
+
+    std::mutex                    m_mutex;
+    size_t                        m_parse_count;
+    size_t                        m_accept_count;
+    size_t                        m_error_recovery_count;
+    std::map<uint32_t, count_t>   m_shifts;
+    std::map<rule_t, count_t>     m_reductions;
+    std::map<rule_t, rule_rhs_t>  m_rule_rhs;
+    std::map<uint32_t, size_t>    m_failures_by_lexer_id;  // the token each failed path died at
+    std::map<int, size_t>         m_failures_by_word_index;
+};
+
+#endif
@@ -23,6 +23,8 @@
 #include "node/XLangNodeIFace.h" // node::NodeIdentIFace
 #include "NatLangLexerIDWrapper.h" // YYLTYPE (generated)
 #include "XLangTreeContext.h" // TreeContext
+#include "ParseBudget.h" // ParseBudget
+#include "GrammarProfile.h" // GrammarProfile
 #include <vector> // std::vector
 #include <list> // std::list
 #include <map> // std::map
@@ -58,10 +60,9 @@ struct ScannerContext
     int         m_length; // length of buf
 
     // location placeholders
-    int m_line;
-    int m_column;
-    int m_prev_column;
-    int m_word_index;
+    uint32_t m_offset; // start of next token
+    int      m_word_index;
+    int      m_error_word_index; // word the first syntax error was found at
 
     std::vector<uint32_t>* m_pos_lexer_id_path;
 
@@ -73,8 +74,9 @@ struct ScannerContext
 class ParserContext
 {
 public:
-    ParserContext(xl::Allocator &alloc, const char* buf)
-        : m_tree_context(alloc), m_scanner_context(buf)
+    ParserContext(xl::Allocator &alloc, const char* buf, ParseBudget* budget = NULL,
+            GrammarProfile* grammar_profile = NULL)
+        : m_tree_context(alloc), m_scanner_context(buf), m_budget(budget), m_grammar_profile(grammar_profile)
     {}
     xl::TreeContext &tree_context()
     {
@@ -84,10 +86,26 @@ public:
     {
         return m_scanner_context;
     }
+    bool budget_exceeded()
+    {
+        return m_budget && !m_budget->check(&m_tree_context.alloc());
+    }
+    GrammarProfile* grammar_profile()
+    {
+        return m_grammar_profile;
+    }
+    // NULL unless profiling, so the grammar only counts when asked to
+    GrammarProfile::ParseCounts* profile_counts()
+    {
+        return m_grammar_profile ? &m_profile_counts : NULL;
+    }
 
 private:
-    xl::TreeContext m_tree_context;
-    ScannerContext  m_scanner_context;
+    xl::TreeContext              m_tree_context;
+    ScannerContext               m_scanner_context;
+    ParseBudget*                 m_budget;
+    GrammarProfile*              m_grammar_profile;
+    GrammarProfile::ParseCounts  m_profile_counts;
 };
 #define YY_EXTRA_TYPE ParserContext*
 
@@ -102,14 +120,46 @@ void yyerror(YYLTYPE* loc, ParserContext* pc, yyscan_t scanner, const char* s);
 void yyerror(const char* s);
 int yylex(YYSTYPE* yylval_param, YYLTYPE* yylloc_param, yyscan_t yyscanner);
 
+// a syntax error as the parser reported it, kept apart from its rendering in
+// error_messages() so it can be rendered again over another sentence whose
+// words sit at the same token boundaries
+struct syntax_error_t
+{
+    bool        m_has_loc;
+    YYLTYPE     m_loc;
+    std::string m_message;
+
+    syntax_error_t(const YYLTYPE* loc, const char* message)
+        : m_has_loc(loc != NULL), m_message(message)
+    {
+        if(loc)
+            m_loc = *loc;
+    }
+};
+
 std::stringstream &error_messages();
+std::vector<syntax_error_t> &syntax_errors(); // those in error_messages()
+void reset_error_messages();
+// renders error as yyerror does, echoing the line of s it was found on
+void print_syntax_error(std::ostream &os, const char* s, const syntax_error_t &error);
 std::string id_to_name(uint32_t lexer_id);
+// "NatLang.y:LINE  LHS -> RHS..." for bison's rule number and the symbol
+// numbers of its right-hand side
+std::string rule_name(int rule, const std::vector<int> &rhs);
 uint32_t name_to_id(std::string name);
 uint32_t quick_lex(const char* s);
+void remap_pos_value_path_to_pos_lexer_id_path(
+        const std::vector<std::string> &pos_value_path,     // IN
+        std::vector<uint32_t>*          pos_lexer_id_path); // OUT
+std::string expand_contractions(std::string &sentence);
 
 xl::node::NodeIdentIFace* make_ast(
-        xl::Allocator &alloc, const char* s,
-        std::map<std::string, uint32_t>* lexer_id_map,
-        std::vector<uint32_t> &pos_lexer_id_path);
+        xl::Allocator         &alloc,
+        const char*            s,
+        std::vector<uint32_t> &pos_lexer_id_path,
+        ParseBudget*           budget = NULL,
+        int*                   error_word_index = NULL,
+        size_t*                unique_string_count = NULL,
+        GrammarProfile*        grammar_profile = NULL);
 
 #endif
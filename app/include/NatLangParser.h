@@ -0,0 +1,271 @@
+// NatLang
+// -- An English parser with an extensible grammar
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef NATLANG_PARSER_H_
+#define NATLANG_PARSER_H_
+
+#include "node/XLangNodeIFace.h" // node::NodeIdentIFace
+#include "XLangAlloc.h" // Allocator
+#include "TryAllParses.h" // PosCache
+#include "ParseShapeCache.h" // ParseShapeCache
+#include "GrammarProfile.h" // GrammarProfile
+#include "SentenceNormalizer.h" // token_view_t
+#include "XLangType.h" // uint32_t
+#include <vector> // std::vector
+#include <string> // std::string
+#include <map> // std::map
+#include <memory> // std::shared_ptr
+#include <algorithm> // std::min, std::remove_if
+#include <stddef.h> // size_t
+
+namespace natlang {
+
+struct ParseOptions
+{
+    // what to do with a sentence whose POS options multiply out to more
+    // than max_estimated_paths paths, decided before any are enumerated
+    typedef enum
+    {
+        ADMISSION_REJECT, // parse nothing
+        ADMISSION_FIRST,  // enumerate at most max_estimated_paths, stop at the first parse
+        ADMISSION_TRIM    // drop the least familiar options of the most ambiguous words
+    } admission_e;
+
+    bool            expand_contractions;
+    double          max_seconds; // per-sentence limits, zero means unlimited
+    size_t          max_paths;
+    size_t          max_bytes;
+    size_t          max_estimated_paths;
+    admission_e     admission;
+    GrammarProfile* grammar_profile; // if set, every path runs the grammar and is counted in it
+
+    ParseOptions()
+        : expand_contractions(true), max_seconds(0), max_paths(0), max_bytes(0), max_estimated_paths(0),
+          admission(ADMISSION_REJECT), grammar_profile(NULL)
+    {}
+};
+
+// one successful reading of a sentence
+struct Interpretation
+{
+    int                       m_path_index;
+    std::vector<std::string>  m_pos_value_path;
+    xl::node::NodeIdentIFace* m_ast;
+
+    Interpretation(int path_index, const std::vector<std::string> &pos_value_path,
+            xl::node::NodeIdentIFace* ast)
+        : m_path_index(path_index), m_pos_value_path(pos_value_path), m_ast(ast)
+    {}
+};
+
+// where the time and memory of one parse went; cheap enough to be kept for
+// every sentence
+struct ParseStats
+{
+    double m_estimated_path_count;  // product of the POS option counts, before any trimming
+    size_t m_trimmed_option_count;  // POS options admission control dropped
+    size_t m_enumerated_path_count; // including paths a limit left untried
+    size_t m_unique_string_count;   // interned by all trees built
+    size_t m_peak_bytes;            // most the result's allocator held at once
+    double m_lookup_seconds;        // normalizing and looking up POS options
+    double m_enumeration_seconds;
+    double m_parse_seconds;         // building trees, over all paths tried
+
+    ParseStats()
+        : m_estimated_path_count(0), m_trimmed_option_count(0), m_enumerated_path_count(0),
+          m_unique_string_count(0), m_peak_bytes(0), m_lookup_seconds(0), m_enumeration_seconds(0),
+          m_parse_seconds(0)
+    {}
+};
+
+// a change to the words of a parsed sentence, indexed as in
+// ParseResult::word(); m_count words are deleted or replaced by m_words
+struct SentenceEdit
+{
+    typedef enum
+    {
+        INSERT,
+        DELETE,
+        REPLACE
+    } type_e;
+
+    type_e                   m_type;
+    size_t                   m_word_index;
+    size_t                   m_count;
+    std::vector<std::string> m_words;
+
+    SentenceEdit(type_e type, size_t word_index, size_t count,
+            const std::vector<std::string> &words = std::vector<std::string>())
+        : m_type(type), m_word_index(word_index), m_count(count), m_words(words)
+    {}
+};
+
+// trees live in the result's allocator, which is released with the last
+// copy of the result
+class ParseResult
+{
+public:
+    // lexer-id prefixes known not to parse, whatever words follow them,
+    // with the errors they failed with; those lie within the prefix, so they
+    // are rendered again over any sentence that keeps its words
+    typedef std::map<std::vector<uint32_t>, std::vector<syntax_error_t>> failed_prefixes_t;
+
+    ParseResult()
+        : m_alloc(new xl::Allocator(__FILE__)), m_path_count(0), m_parse_count(0),
+          m_reused_count(0), m_status(ParseBudget::STATUS_OK)
+    {}
+    const std::string &sentence() const
+    {
+        return m_sentence;
+    }
+    // words of the normalized sentence, not counting the end-of-sentence token
+    size_t word_count() const
+    {
+        return m_tokens.empty() ? 0 : m_tokens.size()-1;
+    }
+    std::string word(size_t index) const
+    {
+        return m_sentence.substr(m_tokens[index].m_offset, m_tokens[index].m_length);
+    }
+    size_t pos_option_count(size_t index) const
+    {
+        return index < m_pos_options_table.size() ? m_pos_options_table[index].size() : 0;
+    }
+    // indices of the ambiguous words with the most POS options, most first,
+    // for telling which words make a sentence expensive
+    std::vector<size_t> costliest_words(size_t count) const
+    {
+        std::vector<size_t> word_indices;
+        estimate_pos_path_count(m_pos_options_table, &word_indices);
+        size_t n = word_count(); // not the end-of-sentence token
+        word_indices.erase(std::remove_if(word_indices.begin(), word_indices.end(),
+                [this, n](size_t i) { return i >= n || m_pos_options_table[i].size() <= 1; }),
+                word_indices.end());
+        word_indices.resize(std::min(count, word_indices.size()));
+        return word_indices;
+    }
+    const std::vector<Interpretation> &interpretations() const
+    {
+        return m_interpretations;
+    }
+    size_t path_count() const
+    {
+        return m_path_count;
+    }
+    size_t parse_count() const
+    {
+        return m_parse_count;
+    }
+    // paths a reparse settled from the previous result without parsing them
+    size_t reused_count() const
+    {
+        return m_reused_count;
+    }
+    // diagnostics of the last path that failed to parse
+    const std::string &error() const
+    {
+        return m_error;
+    }
+    const ParseStats &stats() const
+    {
+        return m_stats;
+    }
+    bool ok() const
+    {
+        return m_parse_count != 0;
+    }
+    // which limit, if any, cut the sentence short
+    ParseBudget::status_e status() const
+    {
+        return m_status;
+    }
+    bool partial() const
+    {
+        return m_status != ParseBudget::STATUS_OK;
+    }
+    xl::Allocator &alloc()
+    {
+        return *m_alloc;
+    }
+
+private:
+    std::shared_ptr<xl::Allocator>        m_alloc;
+    std::string                           m_sentence;
+    std::vector<token_view_t>             m_tokens;
+    std::vector<std::vector<std::string>> m_pos_options_table;
+    failed_prefixes_t                     m_failed_prefixes;
+    std::vector<Interpretation>           m_interpretations;
+    size_t                                m_path_count;
+    size_t                                m_parse_count;
+    size_t                                m_reused_count;
+    std::string                           m_error;
+    ParseBudget::status_e                 m_status;
+    ParseStats                            m_stats;
+
+    friend class Parser;
+};
+
+// entry point for embedding; one Parser may be shared by any number of
+// threads, each parse keeps its state on the calling thread
+class Parser
+{
+public:
+    // called for each interpretation as soon as it parses; its tree is freed
+    // once the callback returns, so return false to stop early
+    typedef bool (*interpretation_cb_t)(const Interpretation &interpretation, void* context);
+
+    Parser()
+    {}
+    ParseResult parse(const std::string &sentence, const ParseOptions &options = ParseOptions());
+    ParseResult parse(const std::string &sentence, interpretation_cb_t interpretation_cb, void* context,
+            const ParseOptions &options = ParseOptions());
+    // parses previous.sentence() with an edit applied, keeping the POS
+    // options of words the edit left alone and skipping paths whose
+    // unchanged prefix already failed to parse
+    ParseResult reparse(const ParseResult &previous, const SentenceEdit &edit,
+            const ParseOptions &options = ParseOptions());
+    ParseResult reparse(const ParseResult &previous, const SentenceEdit &edit,
+            interpretation_cb_t interpretation_cb, void* context,
+            const ParseOptions &options = ParseOptions());
+    PosCache &pos_cache()
+    {
+        return m_pos_cache;
+    }
+    ParseShapeCache &shape_cache()
+    {
+        return m_shape_cache;
+    }
+    // identifies the grammar and lexicon this library was built from, for
+    // keying caches of parse results
+    static const char* build_id();
+
+private:
+    PosCache        m_pos_cache;
+    ParseShapeCache m_shape_cache;
+
+    bool admit(ParseResult* result, const ParseOptions &options, ParseBudget* budget, bool* first_only);
+    void parse_paths(ParseResult* result, const ParseResult* previous, size_t unchanged_word_count,
+            interpretation_cb_t interpretation_cb, void* context, ParseBudget* budget,
+            GrammarProfile* grammar_profile, bool first_only);
+
+    Parser(const Parser&);
+    Parser& operator=(const Parser&);
+};
+
+}
+
+#endif
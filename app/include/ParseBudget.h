@@ -0,0 +1,120 @@
+// NatLang
+// -- An English parser with an extensible grammar
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PARSE_BUDGET_H_
+#define PARSE_BUDGET_H_
+
+#include "XLangAlloc.h" // Allocator
+#include <time.h> // clock_gettime
+#include <stddef.h> // size_t
+
+// per-sentence resource limits, polled by the path enumerator and by the
+// lexer between tokens; zero means unlimited
+class ParseBudget
+{
+public:
+    typedef enum
+    {
+        STATUS_OK,
+        STATUS_TIME_LIMIT,
+        STATUS_PATH_LIMIT,
+        STATUS_MEMORY_LIMIT,
+        STATUS_ESTIMATE_LIMIT
+    } status_e;
+
+    ParseBudget(double max_seconds = 0, size_t max_paths = 0, size_t max_bytes = 0)
+        : m_max_seconds(max_seconds), m_max_paths(max_paths), m_max_bytes(max_bytes),
+          m_status(STATUS_OK), m_path_limit_status(STATUS_PATH_LIMIT), m_stopped(false)
+    {
+        if(m_max_seconds > 0)
+            clock_gettime(CLOCK_MONOTONIC, &m_start_time);
+    }
+    // returns false if no more paths may be enumerated; paths already
+    // enumerated may still be parsed
+    bool check_paths(size_t path_count)
+    {
+        if(m_max_paths && path_count >= m_max_paths)
+        {
+            if(m_status == STATUS_OK)
+                m_status = m_path_limit_status;
+            return false;
+        }
+        return check(NULL);
+    }
+    // tightens the path limit of a sentence whose estimated path count was
+    // over the admission limit; reaching it reports STATUS_ESTIMATE_LIMIT
+    void limit_paths(size_t max_paths)
+    {
+        if(m_max_paths && m_max_paths <= max_paths)
+            return;
+        m_max_paths = max_paths;
+        m_path_limit_status = STATUS_ESTIMATE_LIMIT;
+    }
+    // returns false once time or memory runs out, after which all work on the
+    // sentence should stop
+    bool check(const xl::Allocator* alloc)
+    {
+        if(m_stopped)
+            return false;
+        if(m_max_bytes && alloc && alloc->size() >= m_max_bytes)
+            m_status = STATUS_MEMORY_LIMIT;
+        else if(m_max_seconds > 0 && elapsed_seconds() >= m_max_seconds)
+            m_status = STATUS_TIME_LIMIT;
+        else
+            return true;
+        m_stopped = true;
+        return false;
+    }
+    bool exceeded() const
+    {
+        return m_stopped;
+    }
+    status_e status() const
+    {
+        return m_status;
+    }
+    static const char* status_name(status_e status)
+    {
+        switch(status)
+        {
+            case STATUS_OK:             return "complete";
+            case STATUS_TIME_LIMIT:     return "time_limit";
+            case STATUS_PATH_LIMIT:     return "path_limit";
+            case STATUS_MEMORY_LIMIT:   return "memory_limit";
+            case STATUS_ESTIMATE_LIMIT: return "estimate_limit";
+        }
+        return "";
+    }
+
+private:
+    double          m_max_seconds;
+    size_t          m_max_paths;
+    size_t          m_max_bytes;
+    status_e        m_status;
+    status_e        m_path_limit_status;
+    bool            m_stopped;
+    struct timespec m_start_time;
+
+    double elapsed_seconds() const
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (now.tv_sec-m_start_time.tv_sec)+(now.tv_nsec-m_start_time.tv_nsec)*1e-9;
+    }
+};
+
+#endif
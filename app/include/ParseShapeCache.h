@@ -0,0 +1,103 @@
+// NatLang
+// -- An English parser with an extensible grammar
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PARSE_SHAPE_CACHE_H_
+#define PARSE_SHAPE_CACHE_H_
+
+#include "node/XLangNodeIFace.h" // node::NodeIdentIFace
+#include "XLangAlloc.h" // Allocator
+#include "ParseBudget.h" // ParseBudget
+#include "SentenceNormalizer.h" // token_view_t
+#include "NatLang.h" // syntax_error_t
+#include "XLangType.h" // uint32_t
+#include <vector> // std::vector
+#include <string> // std::string
+#include <map> // std::map
+#include <memory> // std::shared_ptr
+#include <mutex> // std::mutex
+#include <stddef.h> // size_t
+
+// outcome of parsing one lexer-id path. When every word is a plain
+// identifier the scanner hands the parser nothing but the path's lexer ids,
+// so the outcome holds for any such words: either the path fails at a word,
+// or it parses into a tree whose leaves are slots for the words
+class ParseShape
+{
+public:
+    // parses the path over placeholder words; NULL if the parse could not
+    // finish (budget spent) or the tree can't be used as a template
+    static std::shared_ptr<const ParseShape> make(const std::vector<uint32_t> &pos_lexer_id_path,
+            ParseBudget* budget = NULL);
+
+    // words whose tokens the scanner passes through as identifiers
+    static bool is_plain_word(const char* s, size_t n);
+
+    bool parsed() const
+    {
+        return m_template != NULL;
+    }
+    int error_word_index() const
+    {
+        return m_error_word_index;
+    }
+    // errors of a failed path, located over the given words
+    std::vector<syntax_error_t> errors(const std::vector<token_view_t> &tokens) const;
+
+    // builds the tree for the given words in alloc, or returns NULL for a
+    // path that fails
+    xl::node::NodeIdentIFace* instantiate(
+            xl::Allocator                   &alloc,
+            const std::string               &sentence,
+            const std::vector<token_view_t> &tokens,
+            size_t*                          unique_string_count = NULL) const;
+
+private:
+    std::shared_ptr<xl::Allocator> m_alloc; // holds the template
+    xl::node::NodeIdentIFace*      m_template;
+    std::vector<token_view_t>      m_placeholder_tokens;
+    int                            m_error_word_index;
+    std::vector<syntax_error_t>    m_errors; // located in the placeholder sentence
+
+    ParseShape()
+        : m_template(NULL), m_error_word_index(-1)
+    {}
+};
+
+// lexer-id path -> ParseShape, safe to share between threads
+class ParseShapeCache
+{
+public:
+    enum { DEFAULT_MAX_SIZE = 16384 };
+
+    ParseShapeCache(size_t max_size = DEFAULT_MAX_SIZE)
+        : m_max_size(max_size), m_hits(0), m_misses(0)
+    {}
+    // the shape of the path, made and remembered on a miss
+    std::shared_ptr<const ParseShape> get(const std::vector<uint32_t> &pos_lexer_id_path,
+            ParseBudget* budget = NULL);
+    void stats(size_t* size, size_t* hits, size_t* misses);
+
+private:
+    typedef std::map<std::vector<uint32_t>, std::shared_ptr<const ParseShape>> internal_type_t;
+    internal_type_t m_map;
+    size_t          m_max_size;
+    size_t          m_hits;
+    size_t          m_misses;
+    std::mutex      m_mutex;
+};
+
+#endif
@@ -0,0 +1,46 @@
+// NatLang
+// -- An English parser with an extensible grammar
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SENTENCE_NORMALIZER_H_
+#define SENTENCE_NORMALIZER_H_
+
+#include "XLangType.h" // uint32_t
+#include <vector> // std::vector
+#include <string> // std::string
+
+// one word of a normalized sentence, as a byte range into it
+struct token_view_t
+{
+    uint32_t m_offset;
+    uint32_t m_length;
+
+    token_view_t(uint32_t offset, uint32_t length)
+        : m_offset(offset), m_length(length)
+    {}
+};
+
+// expands contractions ("n't", "'ve", "'m", "'re", "'s") and spaces out
+// commas in one pass, writing the words of the sentence separated by single
+// spaces; tokens index the same words for POS lookup, in the order the
+// scanner sees them
+void normalize_sentence(
+        const std::string         &sentence,            // IN
+        std::string*               normalized_sentence, // OUT
+        std::vector<token_view_t>* tokens,              // OUT
+        bool                       expand_contractions = true);
+
+#endif
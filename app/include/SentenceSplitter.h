@@ -0,0 +1,50 @@
+// NatLang
+// -- An English parser with an extensible grammar
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SENTENCE_SPLITTER_H_
+#define SENTENCE_SPLITTER_H_
+
+#include <string> // std::string
+#include <stddef.h> // size_t
+
+// splits text into sentences at ".", "?", "!" and blank lines, reading the
+// caller's buffer in place; a period ends a sentence only when followed by
+// white space or the end of input, and not after an initial or a known
+// abbreviation ("Dr.", "e.g.")
+class SentenceSplitter
+{
+public:
+    SentenceSplitter(const char* buf, size_t n)
+        : m_pos(buf), m_end(buf+n)
+    {}
+    // copies the next sentence, without its terminator and with white space
+    // collapsed; if the buffer ends mid-sentence and more input may follow
+    // (at_eof false), returns false and leaves it to remaining()
+    bool next(std::string* sentence, bool at_eof = true);
+    const char* remaining() const
+    {
+        return m_pos;
+    }
+
+private:
+    const char* m_pos;
+    const char* m_end;
+
+    static bool is_abbreviation(const char* word_begin, const char* period);
+};
+
+#endif
@@ -20,10 +20,37 @@
 
 #include "node/XLangNodeIFace.h" // node::NodeIdentIFace
 #include "XLangAlloc.h" // Allocator
+#include "ParseBudget.h" // ParseBudget
+#include "SentenceNormalizer.h" // token_view_t
 #include <vector> // std::vector
 #include <list> // std::list
 #include <stack> // std::stack
 #include <string> // std::string
+#include <map> // std::map
+#include <mutex> // std::mutex
+#include <stddef.h> // size_t
+
+// word -> POS values, safe to share between threads
+class PosCache
+{
+public:
+    enum { DEFAULT_MAX_SIZE = 65536 };
+
+    PosCache(size_t max_size = DEFAULT_MAX_SIZE)
+        : m_max_size(max_size), m_hits(0), m_misses(0)
+    {}
+    bool lookup(const std::string &word, std::vector<std::string>* pos_values);
+    void insert(const std::string &word, const std::vector<std::string> &pos_values);
+    void stats(size_t* size, size_t* hits, size_t* misses);
+
+private:
+    typedef std::map<std::string, std::vector<std::string>> internal_type_t;
+    internal_type_t m_map;
+    size_t          m_max_size;
+    size_t          m_hits;
+    size_t          m_misses;
+    std::mutex      m_mutex;
+};
 
 bool get_pos_values_from_lexer(
         std::string               word,
@@ -32,20 +59,57 @@ bool get_pos_values_from_lexer(
 bool get_pos_values_from_wordnet(
         std::string               word,
         std::vector<std::string>* pos_values);
-bool get_pos_values(
+bool get_pos_values_uncached(
         std::string               word,
         std::vector<std::string>* pos_values);
+bool get_pos_values(
+        std::string               word,
+        std::vector<std::string>* pos_values,
+        PosCache*                 pos_cache = NULL);
 void build_pos_paths_from_pos_options(
         std::list<std::vector<int>>*                 pos_paths,                  // OUT
-        const std::vector<std::vector<std::string>> &sentence_pos_options_table, // IN
+        const std::vector<std::vector<std::string>>* sentence_pos_options_table, // IN
         std::stack<int>*                             pos_path,                   // TEMP
-        int                                          word_index);                // TEMP
+        int                                          word_index,                 // TEMP
+        ParseBudget*                                 budget = NULL);             // IN
 void build_pos_paths_from_pos_options(
-        std::list<std::vector<int>>*                 pos_paths,                   // OUT
-        const std::vector<std::vector<std::string>> &sentence_pos_options_table); // IN
+        std::list<std::vector<int>>*                 pos_paths,                  // OUT
+        const std::vector<std::vector<std::string>>* sentence_pos_options_table, // IN
+        ParseBudget*                                 budget = NULL);             // IN
+// number of paths the table enumerates to, as a double since it outgrows any
+// integer for long sentences; word_indices gets the words ordered by how many
+// options they contribute, most first
+double estimate_pos_path_count(
+        const std::vector<std::vector<std::string>> &sentence_pos_options_table, // IN
+        std::vector<size_t>*                         word_indices = NULL);       // OUT
+// drops the lowest-ranked options of the most ambiguous words until the table
+// enumerates to at most max_path_count paths; closed-class options from the
+// lexer go only once a word has no other. Returns the options dropped
+size_t trim_pos_options_table(
+        std::vector<std::vector<std::string>>* sentence_pos_options_table, // IN/OUT
+        double                                 max_path_count);            // IN
+// words whose row is already filled in keep it, so a caller can carry the
+// rows of unchanged words over from an earlier sentence
+void build_pos_options_table_from_tokens(
+        std::vector<std::vector<std::string>>* sentence_pos_options_table, // IN/OUT
+        const std::string                     &sentence,                   // IN
+        const std::vector<token_view_t>       &tokens,                     // IN
+        PosCache*                              pos_cache = NULL);          // IN
+void build_pos_value_paths_from_pos_options_table(
+        std::list<std::vector<std::string>>*         pos_value_paths,            // OUT
+        const std::vector<std::vector<std::string>> &sentence_pos_options_table, // IN
+        ParseBudget*                                 budget = NULL);             // IN
+void build_pos_value_paths_from_tokens(
+        std::list<std::vector<std::string>>* pos_value_paths,    // OUT
+        const std::string                   &sentence,           // IN
+        const std::vector<token_view_t>     &tokens,             // IN
+        PosCache*                            pos_cache = NULL,   // IN
+        ParseBudget*                         budget = NULL);     // IN
 void build_pos_value_paths_from_sentence(
-        std::list<std::vector<std::string>>* pos_value_paths, // OUT
-        std::string                          sentence);       // IN
+        std::list<std::vector<std::string>>* pos_value_paths,    // OUT
+        std::string                          sentence,           // IN
+        PosCache*                            pos_cache = NULL,   // IN
+        ParseBudget*                         budget = NULL);     // IN
 void test_build_pos_value_paths();
 
 #endif
@@ -143,17 +143,17 @@ private:
 class SymbolNode : public Node, public SymbolNodeIFace
 {
 public:
-    SymbolNode(uint32_t _lexer_id, YYLTYPE loc, size_t _size, va_list ap);
-    SymbolNode(uint32_t _lexer_id, YYLTYPE loc, std::vector<NodeIdentIFace*>& vec);
+    SymbolNode(TreeContext* tc, uint32_t _lexer_id, YYLTYPE loc, size_t _size, va_list ap);
+    SymbolNode(TreeContext* tc, uint32_t _lexer_id, YYLTYPE loc, std::vector<NodeIdentIFace*>& vec);
 
     // required
     NodeIdentIFace* operator[](uint32_t index) const
     {
-        return m_child_vec[index];
+        return child_arr()[index];
     }
     size_t size() const
     {
-        return m_child_vec.size();
+        return m_size;
     }
 
     // optional
@@ -163,18 +163,19 @@ public:
         if(!is_same_type(_node))
             return false;
         auto symbol_node = dynamic_cast<const SymbolNode*>(_node);
-        if(m_child_vec.size() != symbol_node->size())
+        if(m_size != symbol_node->size())
             return false;
-        for(size_t i = 0; i<m_child_vec.size(); i++)
+        NodeIdentIFace* const* _child_arr = child_arr();
+        for(size_t i = 0; i<m_size; i++)
         {
-            if(!m_child_vec[i]->compare(const_cast<const NodeIdentIFace*>((*symbol_node)[i])))
+            if(!_child_arr[i]->compare(const_cast<const NodeIdentIFace*>((*symbol_node)[i])))
                 return false;
         }
         return true;
     }
     NodeIdentIFace* find(const NodeIdentIFace* _node) const
     {
-        for(auto p = m_child_vec.begin(); p != m_child_vec.end(); p++)
+        for(auto p = child_arr(); p != child_arr()+m_size; p++)
         {
             if((*p)->compare(_node))
                 return (*p);
@@ -197,7 +198,30 @@ public:
     }
 
 private:
-    std::vector<NodeIdentIFace*> m_child_vec;
+    // most grammar rules produce 1-4 children, so keep that many inline and
+    // only spill to the tree context's allocator for longer lists
+    enum { INLINE_CHILD_COUNT = 4 };
+
+    Allocator* m_alloc;
+    uint32_t   m_size;
+    uint32_t   m_capacity;
+    union
+    {
+        NodeIdentIFace*  m_inline_child_arr[INLINE_CHILD_COUNT];
+        NodeIdentIFace** m_spill_child_arr;
+    };
+
+    NodeIdentIFace** child_arr()
+    {
+        return (m_capacity > INLINE_CHILD_COUNT) ? m_spill_child_arr : m_inline_child_arr;
+    }
+    NodeIdentIFace* const* child_arr() const
+    {
+        return (m_capacity > INLINE_CHILD_COUNT) ? m_spill_child_arr : m_inline_child_arr;
+    }
+    void reserve(size_t capacity);
+    void insert_at(size_t index, NodeIdentIFace* _node);
+    void append_child(NodeIdentIFace* child);
 };
 
 } }
@@ -0,0 +1,109 @@
+// NatLang
+// -- An English parser with an extensible grammar
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "GrammarProfile.h" // GrammarProfile
+#include "NatLang.h" // id_to_name, rule_name
+#include <vector> // std::vector
+#include <map> // std::map
+#include <string> // std::string
+#include <algorithm> // std::sort
+#include <iomanip> // std::setw
+
+void GrammarProfile::add_parse(const ParseCounts &counts, const std::vector<uint32_t> &pos_lexer_id_path,
+        bool accepted, int error_word_index)
+{
+    // the last token read is shifted if nothing rejected it
+    std::map<uint32_t, size_t> shifts = counts.m_shifts;
+    if(!counts.m_rejected && counts.m_lookahead)
+        shifts[counts.m_lookahead]++;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_parse_count++;
+    if(accepted)
+        m_accept_count++;
+    m_error_recovery_count += counts.m_error_recovery_count;
+    for(auto p = shifts.begin(); p != shifts.end(); p++)
+    {
+        count_t &count = m_shifts[(*p).first];
+        count.m_total += (*p).second;
+        if(!accepted)
+            count.m_failed += (*p).second;
+    }
+    for(auto p = counts.m_reductions.begin(); p != counts.m_reductions.end(); p++)
+    {
+        count_t &count = m_reductions[(*p).first];
+        count.m_total += (*p).second;
+        if(!accepted)
+            count.m_failed += (*p).second;
+    }
+    m_rule_rhs.insert(counts.m_rule_rhs.begin(), counts.m_rule_rhs.end()); // keeps those already known
+    if(!accepted && error_word_index >= 0 && static_cast<size_t>(error_word_index) < pos_lexer_id_path.size())
+    {
+        m_failures_by_lexer_id[pos_lexer_id_path[error_word_index]]++;
+        m_failures_by_word_index[error_word_index]++;
+    }
+}
+
+template<class K, class V>
+static bool greater_value(const std::pair<K, V> &a, const std::pair<K, V> &b)
+{
+    return b.second < a.second;
+}
+
+void GrammarProfile::print_report(std::ostream &os)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    os << "grammar profile: " << m_parse_count << " paths parsed, " << m_accept_count << " accepted, "
+       << m_error_recovery_count << " error recoveries" << std::endl;
+
+    // sorted by work wasted on failed paths, then by total work
+    std::vector<std::pair<std::string, std::pair<size_t, size_t>>> rows;
+    for(auto p = m_reductions.begin(); p != m_reductions.end(); p++)
+    {
+        rows.push_back(std::make_pair(rule_name((*p).first, m_rule_rhs[(*p).first]),
+                std::make_pair((*p).second.m_failed, (*p).second.m_total)));
+    }
+    std::stable_sort(rows.begin(), rows.end(), greater_value<std::string, std::pair<size_t, size_t>>);
+    os << std::endl << "reductions (failed total rule):" << std::endl;
+    for(auto p = rows.begin(); p != rows.end(); p++)
+    {
+        os << std::setw(10) << (*p).second.first << std::setw(10) << (*p).second.second << "  "
+           << (*p).first << std::endl;
+    }
+    rows.clear();
+    for(auto p = m_shifts.begin(); p != m_shifts.end(); p++)
+    {
+        rows.push_back(std::make_pair(id_to_name((*p).first),
+                std::make_pair((*p).second.m_failed, (*p).second.m_total)));
+    }
+    std::stable_sort(rows.begin(), rows.end(), greater_value<std::string, std::pair<size_t, size_t>>);
+    os << std::endl << "shifts (failed total token):" << std::endl;
+    for(auto p = rows.begin(); p != rows.end(); p++)
+    {
+        os << std::setw(10) << (*p).second.first << std::setw(10) << (*p).second.second << "  "
+           << (*p).first << std::endl;
+    }
+
+    std::vector<std::pair<uint32_t, size_t>> failures(m_failures_by_lexer_id.begin(),
+            m_failures_by_lexer_id.end());
+    std::stable_sort(failures.begin(), failures.end(), greater_value<uint32_t, size_t>);
+    os << std::endl << "failed paths by token they died at (count token):" << std::endl;
+    for(auto p = failures.begin(); p != failures.end(); p++)
+        os << std::setw(10) << (*p).second << "  " << id_to_name((*p).first) << std::endl;
+    os << std::endl << "failed paths by word they died at (count word_index):" << std::endl;
+    for(auto p = m_failures_by_word_index.begin(); p != m_failures_by_word_index.end(); p++)
+        os << std::setw(10) << (*p).second << "  " << (*p).first << std::endl;
+}
@@ -17,61 +17,102 @@
 
 //%output="NatLang.tab.c"
 
+%code requires {
+
+#include "XLangType.h" // uint32_t
+
+// source location of a node, as half-open byte offsets into the scanned
+// buffer (line/column are computed on demand by ScannerContext)
+struct SourceSpan
+{
+    uint32_t begin_offset;
+    uint32_t end_offset;
+};
+#define YYLTYPE SourceSpan
+#define YYLTYPE_IS_DECLARED 1
+
+#define YYLLOC_DEFAULT(Current, Rhs, N)                                   \
+        do {                                                              \
+            if(N)                                                         \
+            {                                                             \
+                (Current).begin_offset = YYRHSLOC(Rhs, 1).begin_offset;   \
+                (Current).end_offset   = YYRHSLOC(Rhs, N).end_offset;     \
+            }                                                             \
+            else                                                          \
+                (Current).begin_offset = (Current).end_offset =           \
+                        YYRHSLOC(Rhs, 0).end_offset;                      \
+        } while(0)
+
+}
+
 %{
 
 #include "NatLang.h"
 #include "node/XLangNodeIFace.h" // node::NodeIdentIFace
 #include "NatLang.tab.h" // ID_XXX (yacc generated)
 #include "XLangAlloc.h" // Allocator
-#include "mvc/XLangMVCView.h" // mvc::MVCView
 #include "mvc/XLangMVCModel.h" // mvc::MVCModel
 #include "XLangTreeContext.h" // TreeContext
-#include "XLangSystem.h" // xl::replace
-#include "XLangString.h" // xl::replace
+#include "SentenceNormalizer.h" // normalize_sentence
 #include "XLangType.h" // uint32_t
-#include "TryAllParses.h" // gen_variations
 #include <stdio.h> // size_t
 #include <stdarg.h> // va_start
 #include <string.h> // strlen
 #include <vector> // std::vector
-#include <list> // std::list
-#include <map> // std::map
 #include <string> // std::string
 #include <sstream> // std::stringstream
 #include <iostream> // std::cout
-#include <stdlib.h> // EXIT_SUCCESS
-#include <getopt.h> // getopt_long
 
 //#define DEBUG
 
 #define MAKE_TERM(lexer_id, ...)   xl::mvc::MVCModel::make_term(&pc->tree_context(), lexer_id, ##__VA_ARGS__)
-#define MAKE_SYMBOL(...)           xl::mvc::MVCModel::make_symbol(&pc->tree_context(), ##__VA_ARGS__)
+#define MAKE_SYMBOL(...)           make_symbol(pc, yyn, yystos, yyssp, yylen, ##__VA_ARGS__)
 #define ERROR_LEXER_ID_NOT_FOUND   "Missing lexer id handler. Did you forgot to register one?"
 #define ERROR_LEXER_NAME_NOT_FOUND "Missing lexer name handler. Did you forgot to register one?"
 
+// counts the reduction by bison's rule number; bison keeps no table of
+// right-hand sides, so the first time a parse reduces a rule, its symbols are
+// read off the states on top of the stack, which the right-hand side shifted
+template<class K, class S, class... T>
+static xl::node::SymbolNode* make_symbol(ParserContext* pc, int rule, const K* state_symbols,
+        const S* top_state, int rhs_size, uint32_t lexer_id, YYLTYPE loc, size_t size, T... children)
+{
+    if(pc->profile_counts() && pc->profile_counts()->record_reduction(rule))
+    {
+        GrammarProfile::rule_rhs_t rhs;
+        for(int i = 1-rhs_size; i <= 0; i++)
+            rhs.push_back(state_symbols[top_state[i]]);
+        pc->profile_counts()->record_rule_rhs(rule, rhs);
+    }
+    return xl::mvc::MVCModel::make_symbol(&pc->tree_context(), lexer_id, loc, size, children...);
+}
+
+// counts tokens on their way to the parser when profiling
+static int profiled_yylex(ParserContext* pc, YYSTYPE* yylval_param, YYLTYPE* yylloc_param, yyscan_t yyscanner)
+{
+    int lexer_id = yylex(yylval_param, yylloc_param, yyscanner);
+    if(pc->profile_counts() && lexer_id > 0)
+        pc->profile_counts()->record_token(lexer_id);
+    return lexer_id;
+}
+#define yylex(yylval_param, yylloc_param, yyscanner) profiled_yylex(pc, yylval_param, yylloc_param, yyscanner)
+
 // report error
 void yyerror(YYLTYPE* loc, ParserContext* pc, yyscan_t scanner, const char* s)
 {
+    if(pc && pc->profile_counts())
+        pc->profile_counts()->record_syntax_error();
+    syntax_error_t error(loc, s);
     if(loc)
     {
-        std::stringstream ss;
-        int last_line_pos = 0;
-        for(int i = pc->scanner_context().m_pos; i >= 0; i--)
-        {
-            if(pc->scanner_context().m_buf[i] == '\n')
-            {
-                last_line_pos = i+1;
-                break;
-            }
-        }
-        ss << &pc->scanner_context().m_buf[last_line_pos] << std::endl;
-        ss << std::string(loc->first_column-1, '-') <<
-                std::string(loc->last_column - loc->first_column + 1, '^') << std::endl <<
-                loc->first_line << ":c" << loc->first_column << " to " <<
-                loc->last_line << ":c" << loc->last_column << std::endl;
-        error_messages() << ss.str();
+        ScannerContext &scanner_context = pc->scanner_context();
+        if(scanner_context.m_error_word_index == -1)
+            scanner_context.m_error_word_index = scanner_context.m_word_index;
+        print_syntax_error(error_messages(), scanner_context.m_buf, error);
     }
-    error_messages() << s;
+    else
+        print_syntax_error(error_messages(), NULL, error);
+    syntax_errors().push_back(error);
 }
 void yyerror(const char* s)
 {
@@ -81,13 +122,51 @@ void yyerror(const char* s)
 // get resource
 std::stringstream &error_messages()
 {
-    static std::stringstream _error_messages;
+    static thread_local std::stringstream _error_messages; // one per server connection
     return _error_messages;
 }
+std::vector<syntax_error_t> &syntax_errors()
+{
+    static thread_local std::vector<syntax_error_t> _syntax_errors;
+    return _syntax_errors;
+}
 void reset_error_messages()
 {
     error_messages().str("");
     error_messages().clear();
+    syntax_errors().clear();
+}
+static void get_line_column(const char* s, uint32_t offset, int* line, int* column)
+{
+    *line = 1;
+    uint32_t line_begin_offset = 0;
+    for(uint32_t i = 0; i<offset && s[i]; i++)
+    {
+        if(s[i] == '\n')
+        {
+            (*line)++;
+            line_begin_offset = i+1;
+        }
+    }
+    *column = offset-line_begin_offset+1;
+}
+void print_syntax_error(std::ostream &os, const char* s, const syntax_error_t &error)
+{
+    if(s && error.m_has_loc)
+    {
+        // line/column are only needed here, so derive them from the span on demand
+        const YYLTYPE &loc = error.m_loc;
+        int first_line = 0, first_column = 0, last_line = 0, last_column = 0;
+        uint32_t last_offset = (loc.end_offset > loc.begin_offset) ? loc.end_offset-1 : loc.begin_offset;
+        get_line_column(s, loc.begin_offset, &first_line, &first_column);
+        get_line_column(s, last_offset,      &last_line,  &last_column);
+        os << &s[loc.begin_offset-(first_column-1)] << std::endl;
+        os << std::string(first_column-1, '-') <<
+                std::string(last_column - first_column + 1, '^') << std::endl <<
+                first_line << ":c" << first_column << " to " <<
+                last_line << ":c" << last_column << std::endl;
+    }
+    os << error.m_message;
 }
 std::string id_to_name(uint32_t lexer_id)
 {
@@ -236,7 +315,7 @@ uint32_t name_to_id(std::string name)
     return 0;
 }
 
-static void remap_pos_value_path_to_pos_lexer_id_path(
+void remap_pos_value_path_to_pos_lexer_id_path(
         const std::vector<std::string> &pos_value_path,    // IN
         std::vector<uint32_t>*          pos_lexer_id_path) // OUT
 {
@@ -246,26 +325,14 @@ static void remap_pos_value_path_to_pos_lexer_id_path(
         pos_lexer_id_path->push_back(name_to_id(*p));
 }
 
-static std::string expand_contractions(std::string &sentence)
+std::string expand_contractions(std::string &sentence)
 {
-    std::string s = sentence;
-    s = xl::replace(s, "n't", " not");
-    s = xl::replace(s, "'ve", " have");
-    s = xl::replace(s, "'m", " am");
-    s = xl::replace(s, "'re", " are");
-    s = xl::replace(s, "'s", " 's");
-    s = xl::replace(s, ",", " , ");
+    std::string s;
+    std::vector<token_view_t> tokens;
+    normalize_sentence(sentence, &s, &tokens);
     return s;
 }
 
-static bool filter_singleton(const xl::node::NodeIdentIFace* _node)
-{
-    if(_node->type() != xl::node::NodeIdentIFace::SYMBOL || _node->height() <= 1)
-        return false;
-    auto symbol = dynamic_cast<const xl::node::SymbolNodeIFace*>(_node);
-    return symbol->size() == 1;
-}
-
 %}
 
 // 'pure_parser' tells bison to use no global variables and create a
@@ -278,6 +345,9 @@ static bool filter_singleton(const xl::node::NodeIdentIFace* _node)
 // show detailed parse errors
 %error-verbose
 
+// emit yyrline, so the grammar profile can name rules by their line
+%debug
+
 // record where each token occurs in input
 %locations
 
@@ -465,7 +535,11 @@ static bool filter_singleton(const xl::node::NodeIdentIFace* _node)
 
 root:
       S_list EOS { pc->tree_context().root() = $1; YYACCEPT; }
-    | error      { yyclearin; /* yyerrok; YYABORT; */ }
+    | error      {
+                     yyclearin; /* yyerrok; YYABORT; */
+                     if(pc->profile_counts())
+                         pc->profile_counts()->record_error_recovery();
+                 }
     ;
 
 S:
@@ -745,9 +819,11 @@ Prep_Adj:
 
 %%
 
+#undef yylex // only the parser's own reads are counted
+
 ScannerContext::ScannerContext(const char* buf)
     : m_scanner(NULL), m_buf(buf), m_pos(0), m_length(strlen(buf)),
-      m_line(1), m_column(1), m_prev_column(1), m_word_index(0),
+      m_offset(0), m_word_index(0), m_error_word_index(-1),
       m_pos_lexer_id_path(NULL)
 {}
 
@@ -761,6 +837,15 @@ uint32_t ScannerContext::current_lexer_id()
     return (*m_pos_lexer_id_path)[m_word_index];
 }
 
+std::string rule_name(int rule, const std::vector<int> &rhs)
+{
+    std::stringstream ss;
+    ss << "NatLang.y:" << yyrline[rule] << "  " << yytname[yyr1[rule]] << " ->";
+    for(auto p = rhs.begin(); p != rhs.end(); p++)
+        ss << ' ' << yytname[*p];
+    return ss.str();
+}
+
 uint32_t quick_lex(const char* s)
 {
     xl::Allocator alloc(__FILE__);
@@ -778,286 +863,28 @@ uint32_t quick_lex(const char* s)
 xl::node::NodeIdentIFace* make_ast(
         xl::Allocator         &alloc,
         const char*            s,
-        std::vector<uint32_t> &pos_lexer_id_path)
+        std::vector<uint32_t> &pos_lexer_id_path,
+        ParseBudget*           budget,
+        int*                   error_word_index,
+        size_t*                unique_string_count,
+        GrammarProfile*        grammar_profile)
 {
-    ParserContext parser_context(alloc, s);
+    ParserContext parser_context(alloc, s, budget, grammar_profile);
     parser_context.scanner_context().m_pos_lexer_id_path = &pos_lexer_id_path;
     yyscan_t scanner = parser_context.scanner_context().m_scanner;
     yylex_init(&scanner);
     yyset_extra(&parser_context, scanner);
     int error_code = yyparse(&parser_context, scanner); // parser entry point
     yylex_destroy(scanner);
-    return (!error_code && error_messages().str().empty()) ? parser_context.tree_context().root() : NULL;
-}
-
-void display_usage(bool verbose)
-{
-    std::cout << "Usage: NatLang [-i] OPTION [-m]" << std::endl;
-    if(verbose)
-    {
-        std::cout << "Parses input and prints a syntax tree to standard out" << std::endl
-                << std::endl
-                << "Input control:" << std::endl
-                << "  -i, --in-xml FILENAME (de-serialize from xml)" << std::endl
-                << "  -e, --expr EXPRESSION" << std::endl
-                << std::endl
-                << "Output control:" << std::endl
-                << "  -l, --lisp" << std::endl
-                << "  -x, --xml" << std::endl
-                << "  -g, --graph" << std::endl
-                << "  -d, --dot" << std::endl
-                << "  -s, --skip_singleton" << std::endl
-                << "  -m, --memory" << std::endl
-                << "  -h, --help" << std::endl;
-    }
-    else
-        std::cout << "Try `NatLang --help\' for more information." << std::endl;
-}
-
-struct options_t
-{
-    typedef enum
-    {
-        MODE_NONE,
-        MODE_LISP,
-        MODE_XML,
-        MODE_GRAPH,
-        MODE_DOT,
-        MODE_HELP
-    } mode_e;
-
-    mode_e      mode;
-    std::string in_xml;
-    std::string expr;
-    bool        dump_memory;
-    bool        skip_singleton;
-
-    options_t()
-        : mode(MODE_NONE), dump_memory(false), skip_singleton(false)
-    {}
-};
-
-bool extract_options_from_args(options_t* options, int argc, char** argv)
-{
-    if(!options)
-        return false;
-    int opt = 0;
-    int longIndex = 0;
-    static const char *optString = "i:e:lxgdsmh?";
-    static const struct option longOpts[] = {
-                { "in-xml",         required_argument, NULL, 'i' },
-                { "expr",           required_argument, NULL, 'e' },
-                { "lisp",           no_argument,       NULL, 'l' },
-                { "xml",            no_argument,       NULL, 'x' },
-                { "graph",          no_argument,       NULL, 'g' },
-                { "dot",            no_argument,       NULL, 'd' },
-                { "skip_singleton", no_argument,       NULL, 's' },
-                { "memory",         no_argument,       NULL, 'm' },
-                { "help",           no_argument,       NULL, 'h' },
-                { NULL,             no_argument,       NULL, 0 }
-            };
-    opt = getopt_long(argc, argv, optString, longOpts, &longIndex);
-    while(opt != -1)
-    {
-        switch(opt)
-        {
-            case 'i': options->in_xml = optarg; break;
-            case 'e': options->expr = optarg; break;
-            case 'l': options->mode = options_t::MODE_LISP; break;
-            case 'x': options->mode = options_t::MODE_XML; break;
-            case 'g': options->mode = options_t::MODE_GRAPH; break;
-            case 'd': options->mode = options_t::MODE_DOT; break;
-            case 's': options->skip_singleton = true; break;
-            case 'm': options->dump_memory = true; break;
-            case 'h':
-            case '?': options->mode = options_t::MODE_HELP; break;
-            case 0: // reserved
-            default:
-                break;
-        }
-        opt = getopt_long(argc, argv, optString, longOpts, &longIndex);
-    }
-    return options->mode != options_t::MODE_NONE || options->dump_memory;
-}
-
-struct pos_value_path_ast_tuple_t
-{
-    std::vector<std::string>  m_pos_value_path;
-    xl::node::NodeIdentIFace* m_ast;
-    int                       m_path_index;
-
-    pos_value_path_ast_tuple_t(
-            std::vector<std::string>  &pos_value_path,
-            xl::node::NodeIdentIFace*  ast,
-            int                        path_index)
-        : m_pos_value_path(pos_value_path),
-          m_ast(ast),
-          m_path_index(path_index) {}
-};
-
-bool import_ast(
-        options_t                   &options,
-        xl::Allocator               &alloc,
-        pos_value_path_ast_tuple_t*  pos_value_path_ast_tuple)
-{
-    if(!pos_value_path_ast_tuple)
-        return false;
-    if(options.in_xml.size())
-    {
-        #if 0 // NOTE: not supported
-            xl::node::NodeIdentIFace* _ast = xl::mvc::MVCModel::make_ast(
-                    new (PNEW(alloc, xl::, TreeContext)) xl::TreeContext(alloc),
-                    options.in_xml);
-            if(!_ast)
-            {
-                std::cerr << "ERROR: de-serialize from xml fail!" << std::endl;
-                return false;
-            }
-            pos_value_path_ast_tuple->m_ast = _ast;
-        #endif
-    }
-    else
-    {
-        std::vector<std::string> &pos_value_path = pos_value_path_ast_tuple->m_pos_value_path;
-        std::string pos_value_path_str;
-        for(auto p = pos_value_path.begin(); p != pos_value_path.end(); p++)
-            pos_value_path_str.append(*p + " ");
-        #ifdef DEBUG
-            std::cerr << "INFO: import path #" <<
-                    pos_value_path_ast_tuple->m_path_index <<
-                    ": <" << pos_value_path_str << ">" << std::endl;
-        #endif
-        std::vector<uint32_t> pos_lexer_id_path;
-        remap_pos_value_path_to_pos_lexer_id_path(pos_value_path, &pos_lexer_id_path);
-        xl::node::NodeIdentIFace* _ast =
-                make_ast(alloc, options.expr.c_str(), pos_lexer_id_path);
-        if(!_ast)
-        {
-            #ifdef DEBUG
-                std::cerr << "ERROR: " << error_messages().str().c_str() << std::endl;
-            #endif
-            reset_error_messages();
-            pos_value_path_ast_tuple->m_ast = NULL;
-            return false;
-        }
-        xl::mvc::MVCView::annotate_tree(_ast);
-        pos_value_path_ast_tuple->m_ast = _ast;
-    }
-    return true;
-}
-
-void export_ast(
-        options_t                  &options,
-        pos_value_path_ast_tuple_t &pos_value_path_ast_tuple)
-{
-    xl::node::NodeIdentIFace* ast = pos_value_path_ast_tuple.m_ast;
-    if(!ast)
-        return;
-    std::vector<std::string> &pos_value_path = pos_value_path_ast_tuple.m_pos_value_path;
-    std::string pos_value_path_str;
-    for(auto p = pos_value_path.begin(); p != pos_value_path.end(); p++)
-        pos_value_path_str.append(*p + " ");
-    std::cerr << "INFO: export path #" <<
-            pos_value_path_ast_tuple.m_path_index <<
-            ": <" << pos_value_path_str << ">" << std::endl;
-    xl::visitor::Filterable::filter_cb_t filter_cb = NULL;
-    if(options.skip_singleton)
-    {
-        filter_cb = filter_singleton;
-        if(options.mode == options_t::MODE_GRAPH || options.mode == options_t::MODE_DOT)
-        {
-            std::cerr << "ERROR: \"skip_singleton\" not supported for this mode!" << std::endl;
-            return;
-        }
-    }
-    switch(options.mode)
-    {
-        case options_t::MODE_LISP:  xl::mvc::MVCView::print_lisp(ast, filter_cb); break;
-        case options_t::MODE_XML:   xl::mvc::MVCView::print_xml(ast, filter_cb); break;
-        case options_t::MODE_GRAPH: xl::mvc::MVCView::print_graph(ast); break;
-        case options_t::MODE_DOT:   xl::mvc::MVCView::print_dot(ast, false, false); break;
-        default:
-            break;
-    }
-}
-
-bool apply_options(options_t &options)
-{
-    if(options.mode == options_t::MODE_HELP)
-    {
-        display_usage(true);
-        return true;
-    }
-    xl::Allocator alloc(__FILE__);
-    if(options.expr.empty() || options.in_xml.size())
-    {
-        std::cerr << "ERROR: mode not supported!" << std::endl;
-        if(options.dump_memory)
-            alloc.dump(std::string(1, '\t'));
-        return false;
-    }
-    std::list<std::vector<std::string>> pos_value_paths;
-    std::string sentence = options.expr;
-    options.expr = sentence = expand_contractions(sentence);
-    build_pos_value_paths_from_sentence(&pos_value_paths, sentence);
-    int path_index = 0;
-    std::list<pos_value_path_ast_tuple_t> pos_value_path_ast_tuples;
-    for(auto p = pos_value_paths.begin(); p != pos_value_paths.end(); p++)
-    {
-        pos_value_path_ast_tuples.push_back(pos_value_path_ast_tuple_t(*p, NULL, path_index));
-        path_index++;
-    }
-    for(auto q = pos_value_path_ast_tuples.begin(); q != pos_value_path_ast_tuples.end(); q++)
-    {
-        try
-        {
-            if(!import_ast(options, alloc, &(*q)))
-                continue;
-        }
-        catch(const char* s)
-        {
-            std::cerr << "ERROR: " << s << std::endl;
-            continue;
-        }
-    }
-    if(options.mode == options_t::MODE_DOT)
-    {
-        xl::mvc::MVCView::print_dot_header(false);
-        for(auto r = pos_value_path_ast_tuples.begin(); r != pos_value_path_ast_tuples.end(); r++)
-            export_ast(options, *r);
-        xl::mvc::MVCView::print_dot_footer();
-    }
-    else
-    {
-        for(auto r = pos_value_path_ast_tuples.begin(); r != pos_value_path_ast_tuples.end(); r++)
-            export_ast(options, *r);
-    }
-    if(options.dump_memory)
-        alloc.dump(std::string(1, '\t'));
-    return true;
-}
-
-void add_signal_handlers()
-{
-    xl::system::add_sighandler(SIGABRT, xl::system::backtrace_sighandler);
-    xl::system::add_sighandler(SIGINT,  xl::system::backtrace_sighandler);
-    xl::system::add_sighandler(SIGSEGV, xl::system::backtrace_sighandler);
-    xl::system::add_sighandler(SIGFPE,  xl::system::backtrace_sighandler);
-    xl::system::add_sighandler(SIGBUS,  xl::system::backtrace_sighandler);
-    xl::system::add_sighandler(SIGILL,  xl::system::backtrace_sighandler);
-}
-
-int main(int argc, char** argv)
-{
-    add_signal_handlers();
-    options_t options;
-    if(!extract_options_from_args(&options, argc, argv))
+    if(error_word_index)
+        *error_word_index = parser_context.scanner_context().m_error_word_index;
+    if(unique_string_count)
+        *unique_string_count = parser_context.tree_context().unique_string_count();
+    bool accepted = !error_code && error_messages().str().empty();
+    if(grammar_profile)
     {
-        display_usage(false);
-        return EXIT_FAILURE;
+        grammar_profile->add_parse(*parser_context.profile_counts(), pos_lexer_id_path, accepted,
+                parser_context.scanner_context().m_error_word_index);
     }
-    options.expr.append(" .");
-    if(!apply_options(options))
-        return EXIT_FAILURE;
-    return EXIT_SUCCESS;
+    return accepted ? parser_context.tree_context().root() : NULL;
 }
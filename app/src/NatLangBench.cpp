@@ -0,0 +1,349 @@
+// NatLang
+// -- An English parser with an extensible grammar
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "NatLangParser.h" // natlang::Parser
+#include "NatLang.h" // make_ast
+#include "TryAllParses.h" // build_pos_options_table_from_tokens
+#include "SentenceNormalizer.h" // normalize_sentence
+#include "node/XLangNodeIFace.h" // node::NodeIdentIFace
+#include "mvc/XLangMVCView.h" // mvc::MVCView
+#include "XLangAlloc.h" // Allocator
+#include "XLangString.h" // xl::tokenize
+#include <vector> // std::vector
+#include <list> // std::list
+#include <map> // std::map
+#include <string> // std::string
+#include <sstream> // std::stringstream
+#include <fstream> // std::ifstream
+#include <iostream> // std::cout
+#include <iomanip> // std::setprecision
+#include <algorithm> // std::sort
+#include <stdlib.h> // EXIT_SUCCESS
+#include <getopt.h> // getopt_long
+#include <time.h> // clock_gettime
+#include <sys/resource.h> // getrusage
+
+// sentences are grouped by length and by how many POS paths they have, the
+// product of their words' POS option counts
+#define SHORT_SENTENCE_WORDS  5
+#define MEDIUM_SENTENCE_WORDS 10
+#define LOW_AMBIGUITY_PATHS   64
+#define MEDIUM_AMBIGUITY_PATHS 4096
+#define DEFAULT_REPEAT        5
+#define DEFAULT_TOLERANCE     20 // percent
+#define MIN_REGRESSION_US     50 // smaller slow-downs are timer noise
+
+struct bench_options_t
+{
+    std::string corpus;
+    std::string out;
+    std::string baseline;
+    int         repeat;
+    double      tolerance;
+
+    bench_options_t()
+        : repeat(DEFAULT_REPEAT), tolerance(DEFAULT_TOLERANCE)
+    {}
+};
+
+void display_usage()
+{
+    std::cout << "Usage: NatLangBench -c CORPUS [-n REPEAT] [-o OUT] [-b BASELINE] [-t TOLERANCE]" << std::endl
+            << "Times each stage of parsing the corpus, one sentence per line" << std::endl
+            << std::endl
+            << "  -c, --corpus FILENAME" << std::endl
+            << "  -n, --repeat N (runs per sentence, default " << DEFAULT_REPEAT << ")" << std::endl
+            << "  -o, --out FILENAME (tab-separated results, default standard out)" << std::endl
+            << "  -b, --baseline FILENAME (results to compare against)" << std::endl
+            << "  -t, --tolerance PERCENT (slow-down counted as a regression, default "
+                    << DEFAULT_TOLERANCE << ")" << std::endl
+            << "  -h, --help" << std::endl;
+}
+
+bool extract_options_from_args(bench_options_t* options, int argc, char** argv)
+{
+    if(!options)
+        return false;
+    int opt = 0;
+    int longIndex = 0;
+    static const char *optString = "c:n:o:b:t:h?";
+    static const struct option longOpts[] = {
+                { "corpus",    required_argument, NULL, 'c' },
+                { "repeat",    required_argument, NULL, 'n' },
+                { "out",       required_argument, NULL, 'o' },
+                { "baseline",  required_argument, NULL, 'b' },
+                { "tolerance", required_argument, NULL, 't' },
+                { "help",      no_argument,       NULL, 'h' },
+                { NULL,        no_argument,       NULL, 0 }
+            };
+    opt = getopt_long(argc, argv, optString, longOpts, &longIndex);
+    while(opt != -1)
+    {
+        switch(opt)
+        {
+            case 'c': options->corpus = optarg; break;
+            case 'n': options->repeat = std::max(1, atoi(optarg)); break;
+            case 'o': options->out = optarg; break;
+            case 'b': options->baseline = optarg; break;
+            case 't': options->tolerance = atof(optarg); break;
+            case 'h':
+            case '?':
+            default:
+                return false;
+        }
+        opt = getopt_long(argc, argv, optString, longOpts, &longIndex);
+    }
+    return options->corpus.size();
+}
+
+static double now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1e6+ts.tv_nsec/1e3;
+}
+
+// latencies of one stage, in microseconds per sentence
+typedef std::map<std::pair<std::string, std::string>, std::vector<double>> samples_t;
+
+static void add_sample(samples_t* samples, const std::string &group, const std::string &stage, double us)
+{
+    (*samples)[std::make_pair(group, stage)].push_back(us);
+    (*samples)[std::make_pair(std::string("all"), stage)].push_back(us);
+}
+
+static std::string group_name(size_t word_count, size_t path_count)
+{
+    std::string length = (word_count <= SHORT_SENTENCE_WORDS)  ? "short" :
+                         (word_count <= MEDIUM_SENTENCE_WORDS) ? "medium" : "long";
+    std::string ambiguity = (path_count <= LOW_AMBIGUITY_PATHS)    ? "low" :
+                            (path_count <= MEDIUM_AMBIGUITY_PATHS) ? "medium" : "high";
+    return length + "/" + ambiguity;
+}
+
+static void export_tree(const std::string &stage, xl::node::NodeIdentIFace* ast, std::ostream &os)
+{
+    if(stage == "output_lisp")
+        xl::mvc::MVCView::print_lisp(ast, NULL, os);
+    else if(stage == "output_xml")
+        xl::mvc::MVCView::print_xml(ast, NULL, os);
+    else if(stage == "output_json")
+        xl::mvc::MVCView::print_json(ast, NULL, os);
+    else if(stage == "output_dot")
+        xl::mvc::MVCView::print_dot(ast, false, true, os);
+    else if(stage == "output_graph")
+        xl::mvc::MVCView::print_graph(ast, os);
+    else if(stage == "output_binary")
+        xl::mvc::MVCView::print_binary(ast, os);
+}
+
+// times each stage of one sentence on its own, so a change shows up in the
+// stage it belongs to
+static void bench_sentence(const std::string &sentence, natlang::Parser &parser, int repeat, samples_t* samples)
+{
+    static const char* output_stages[] = {
+            "output_lisp", "output_xml", "output_json", "output_dot", "output_graph", "output_binary"};
+    std::string normalized_sentence;
+    std::vector<token_view_t> tokens;
+    normalize_sentence(sentence + " .", &normalized_sentence, &tokens);
+    std::string group;
+    for(int i = 0; i<repeat; i++)
+    {
+        double t0 = now_us();
+        PosCache pos_cache; // cold, so lookups are measured rather than the cache
+        std::vector<std::vector<std::string>> sentence_pos_options_table;
+        build_pos_options_table_from_tokens(&sentence_pos_options_table, normalized_sentence, tokens,
+                &pos_cache);
+        double t1 = now_us();
+        std::list<std::vector<std::string>> pos_value_paths;
+        build_pos_value_paths_from_pos_options_table(&pos_value_paths, sentence_pos_options_table);
+        double t2 = now_us();
+        if(group.empty())
+            group = group_name(tokens.size()-1, pos_value_paths.size());
+        add_sample(samples, group, "pos_lookup", t1-t0);
+        add_sample(samples, group, "path_enumeration", t2-t1);
+
+        // the grammar alone, without the parse shape cache
+        xl::Allocator alloc(__FILE__);
+        std::vector<xl::node::NodeIdentIFace*> asts;
+        for(auto p = pos_value_paths.begin(); p != pos_value_paths.end(); p++)
+        {
+            std::vector<uint32_t> pos_lexer_id_path;
+            remap_pos_value_path_to_pos_lexer_id_path(*p, &pos_lexer_id_path);
+            xl::node::NodeIdentIFace* ast = NULL;
+            try
+            {
+                ast = make_ast(alloc, normalized_sentence.c_str(), pos_lexer_id_path);
+            }
+            catch(const char*)
+            {}
+            reset_error_messages();
+            if(ast)
+                asts.push_back(ast);
+        }
+        double t3 = now_us();
+        add_sample(samples, group, "parse", t3-t2);
+
+        // what an embedder sees, caches warm after the first run
+        double t4 = now_us();
+        parser.parse(sentence);
+        double t5 = now_us();
+        add_sample(samples, group, "end_to_end", t5-t4);
+
+        if(asts.empty())
+            continue;
+        double t6 = now_us();
+        for(auto p = asts.begin(); p != asts.end(); p++)
+            xl::mvc::MVCView::annotate_tree(*p);
+        double t7 = now_us();
+        add_sample(samples, group, "annotation", t7-t6);
+        for(size_t j = 0; j<sizeof(output_stages)/sizeof(*output_stages); j++)
+        {
+            std::stringstream ss;
+            double t8 = now_us();
+            for(auto p = asts.begin(); p != asts.end(); p++)
+                export_tree(output_stages[j], *p, ss);
+            double t9 = now_us();
+            add_sample(samples, group, output_stages[j], t9-t8);
+        }
+    }
+}
+
+static double percentile(const std::vector<double> &sorted_samples, double pct)
+{
+    size_t index = static_cast<size_t>(pct/100*(sorted_samples.size()-1)+0.5);
+    return sorted_samples[std::min(index, sorted_samples.size()-1)];
+}
+
+// one "group stage metric value" row per measurement, so results from
+// different builds can be compared line by line
+static void print_results(const samples_t &samples, std::ostream &os)
+{
+    os << "group\tstage\tmetric\tvalue" << std::endl;
+    os << std::fixed << std::setprecision(1);
+    for(auto p = samples.begin(); p != samples.end(); p++)
+    {
+        std::vector<double> sorted_samples = (*p).second;
+        std::sort(sorted_samples.begin(), sorted_samples.end());
+        double total_us = 0;
+        for(auto q = sorted_samples.begin(); q != sorted_samples.end(); q++)
+            total_us += *q;
+        std::string prefix = (*p).first.first + "\t" + (*p).first.second + "\t";
+        os << prefix << "samples\t"  << sorted_samples.size() << std::endl;
+        os << prefix << "p50_us\t"   << percentile(sorted_samples, 50) << std::endl;
+        os << prefix << "p90_us\t"   << percentile(sorted_samples, 90) << std::endl;
+        os << prefix << "p99_us\t"   << percentile(sorted_samples, 99) << std::endl;
+        os << prefix << "max_us\t"   << sorted_samples.back() << std::endl;
+        os << prefix << "per_sec\t"  << (total_us ? sorted_samples.size()*1e6/total_us : 0) << std::endl;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    os << "all\tprocess\tpeak_rss_kb\t" << usage.ru_maxrss << std::endl;
+}
+
+static bool read_results(std::string filename, std::map<std::string, double>* results)
+{
+    std::ifstream file(filename.c_str());
+    if(!file.is_open())
+        return false;
+    std::string line;
+    std::getline(file, line); // header
+    while(std::getline(file, line))
+    {
+        std::vector<std::string> fields = xl::tokenize(line, "\t");
+        if(fields.size() == 4)
+            (*results)[fields[0] + "\t" + fields[1] + "\t" + fields[2]] = atof(fields[3].c_str());
+    }
+    return true;
+}
+
+// returns the number of regressions: median latencies or peak memory that
+// grew by more than the tolerance; the tail percentiles are reported but too
+// noisy to gate on
+static int compare_results(std::string out, std::string baseline, double tolerance)
+{
+    std::map<std::string, double> current_results;
+    std::map<std::string, double> baseline_results;
+    if(!read_results(out, &current_results) || !read_results(baseline, &baseline_results))
+    {
+        std::cerr << "ERROR: cannot read \"" << baseline << "\"" << std::endl;
+        return -1;
+    }
+    int regression_count = 0;
+    for(auto p = baseline_results.begin(); p != baseline_results.end(); p++)
+    {
+        const std::string &key = (*p).first;
+        bool is_latency = (key.find("\tp50_us") != std::string::npos);
+        if(!is_latency && key.find("\tpeak_rss_kb") == std::string::npos)
+            continue;
+        auto q = current_results.find(key);
+        if(q == current_results.end() || !(*p).second)
+            continue;
+        double change_pct = ((*q).second-(*p).second)/(*p).second*100;
+        if(change_pct > tolerance && (!is_latency || (*q).second-(*p).second >= MIN_REGRESSION_US))
+        {
+            std::string name = key;
+            std::replace(name.begin(), name.end(), '\t', ' ');
+            std::cerr << "REGRESSION: " << name << ": " << (*p).second << " -> " << (*q).second << std::endl;
+            regression_count++;
+        }
+    }
+    return regression_count;
+}
+
+int main(int argc, char** argv)
+{
+    bench_options_t options;
+    if(!extract_options_from_args(&options, argc, argv))
+    {
+        display_usage();
+        return EXIT_FAILURE;
+    }
+    std::ifstream corpus(options.corpus.c_str());
+    if(!corpus.is_open())
+    {
+        std::cerr << "ERROR: cannot open \"" << options.corpus << "\"!" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::stringstream null_stream;
+    std::streambuf* cerr_buf = std::cerr.rdbuf(null_stream.rdbuf()); // silence INFO traces
+    natlang::Parser parser;
+    samples_t samples;
+    std::string sentence;
+    while(std::getline(corpus, sentence))
+    {
+        if(sentence.empty() || sentence[0] == '#')
+            continue;
+        bench_sentence(sentence, parser, options.repeat, &samples);
+        null_stream.str("");
+    }
+    std::cerr.rdbuf(cerr_buf);
+    if(options.out.empty())
+        print_results(samples, std::cout);
+    else
+    {
+        std::ofstream out(options.out.c_str());
+        print_results(samples, out);
+    }
+    if(options.baseline.empty() || options.out.empty())
+        return EXIT_SUCCESS;
+    int regression_count = compare_results(options.out, options.baseline, options.tolerance);
+    if(regression_count < 0)
+        return EXIT_FAILURE;
+    std::cerr << regression_count << " regression(s) against \"" << options.baseline << "\"" << std::endl;
+    return regression_count ? EXIT_FAILURE : EXIT_SUCCESS;
+}
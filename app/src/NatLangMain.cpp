@@ -0,0 +1,1203 @@
+// NatLang
+// -- An English parser with an extensible grammar
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "NatLangParser.h" // natlang::Parser
+#include "GrammarProfile.h" // GrammarProfile
+#include "SentenceSplitter.h" // SentenceSplitter
+#include "node/XLangNodeIFace.h" // node::NodeIdentIFace
+#include "XLangAlloc.h" // Allocator
+#include "mvc/XLangMVCView.h" // mvc::MVCView
+#include "mvc/XLangMVCModel.h" // mvc::MVCModel
+#include "visitor/XLangPrinter.h" // visitor::JsonPrinter
+#include "XLangTreeContext.h" // TreeContext
+#include "XLangSystem.h" // xl::system::add_sighandler
+#include "XLangSink.h" // xl::FdSink
+#include "XLangMappedFile.h" // xl::MappedFile
+#include "XLangBinary.h" // xl::binary::TreeView
+#include "XLangXMLReader.h" // xl::XMLReader
+#include "XLangDiskCache.h" // xl::DiskCache
+#include "XLangTrace.h" // xl::trace::Span
+#include "SentenceNormalizer.h" // normalize_sentence
+#include <stdio.h> // perror
+#include <string.h> // strcpy
+#include <vector> // std::vector
+#include <map> // std::map
+#include <algorithm> // std::max
+#include <string> // std::string
+#include <fstream> // std::ifstream
+#include <sstream> // std::stringstream
+#include <iostream> // std::cout
+#include <stdlib.h> // EXIT_SUCCESS
+#include <getopt.h> // getopt_long
+#include <unistd.h> // STDOUT_FILENO
+#include <sys/socket.h> // socket
+#include <sys/un.h> // sockaddr_un
+#include <signal.h> // signal
+#include <errno.h> // errno
+#include <time.h> // time
+#include <thread> // std::thread
+#include <mutex> // std::mutex
+#include <condition_variable> // std::condition_variable
+#include <deque> // std::deque
+#include <list> // std::list
+#include <atomic> // std::atomic
+#include <memory> // std::unique_ptr
+
+#define SENTENCE_DELIMITER  "\f" // ends each sentence of batch output, followed by the
+                                  // limit that cut it short, if any
+#define SERVE_STATS_REQUEST "#stats"
+#define SERVE_MAX_LINE_SIZE 65536
+#define SERVE_RETRY_US      100000 // between accepts while out of descriptors
+#define STDIN_CHUNK_SIZE    65536
+#define RESULT_CACHE_SIZE   (256*1024*1024) // default cap in bytes
+#define RESULT_CACHE_ALIGN  8 // tree blocks are read in place
+#define REPORTED_WORD_COUNT 3 // most ambiguous words named when a sentence is over its estimate
+
+static bool filter_singleton(const xl::node::NodeIdentIFace* _node)
+{
+    if(_node->type() != xl::node::NodeIdentIFace::SYMBOL || _node->height() <= 1)
+        return false;
+    auto symbol = dynamic_cast<const xl::node::SymbolNodeIFace*>(_node);
+    return symbol->size() == 1;
+}
+
+void display_usage(bool verbose)
+{
+    std::cout << "Usage: NatLang [-i] OPTION [-m]" << std::endl;
+    if(verbose)
+    {
+        std::cout << "Parses input and prints a syntax tree to standard out" << std::endl
+                << std::endl
+                << "Input control:" << std::endl
+                << "  -i, --in-xml FILENAME (de-serialize from xml)" << std::endl
+                << "  -B, --in-binary FILENAME (de-serialize from binary)" << std::endl
+                << "  -f, --in-file FILENAME (one or more sentences)" << std::endl
+                << "  -r, --stdin (one or more sentences)" << std::endl
+                << "  -J, --jobs N (parse batch input on N threads)" << std::endl
+                << "  -L, --serve SOCKET (one sentence per line, \"" SERVE_STATS_REQUEST "\" for stats)" << std::endl
+                << "  -T, --max-seconds SECONDS (per sentence)" << std::endl
+                << "  -P, --max-paths N (per sentence)" << std::endl
+                << "  -M, --max-bytes N (per sentence)" << std::endl
+                << "  -A, --max-estimated-paths N (checked before enumerating any)" << std::endl
+                << "  -a, --admission POLICY (reject, first or trim; default reject)" << std::endl
+                << "  -C, --result-cache DIR (reuse parses of repeated sentences)" << std::endl
+                << "  -Z, --result-cache-size BYTES (default " << RESULT_CACHE_SIZE << ")" << std::endl
+                << "  -e, --expr EXPRESSION" << std::endl
+                << "  -R, --reparse EDIT (applied to --expr in turn; \"insert INDEX WORD...\"," << std::endl
+                << "                      \"delete INDEX COUNT\" or \"replace INDEX COUNT WORD...\")" << std::endl
+                << std::endl
+                << "Output control:" << std::endl
+                << "  -l, --lisp" << std::endl
+                << "  -x, --xml" << std::endl
+                << "  -g, --graph" << std::endl
+                << "  -d, --dot" << std::endl
+                << "  -b, --binary" << std::endl
+                << "  -j, --json (one line per parse)" << std::endl
+                << "  -w, --split (print each sentence of batch input on a line, without parsing)" << std::endl
+                << "  -s, --skip_singleton" << std::endl
+                << "  -S, --stream (export each parse as soon as it is found)" << std::endl
+                << "  -m, --memory" << std::endl
+                << "  -t, --stats (timings and counters to stderr, one JSON line per sentence if batching)"
+                << std::endl
+                << "  -G, --grammar-profile (rule and token counts over all input to stderr)" << std::endl
+                << "  -E, --trace FILENAME (Chrome trace-event JSON of each stage)" << std::endl
+                << "  -h, --help" << std::endl;
+    }
+    else
+        std::cout << "Try `NatLang --help\' for more information." << std::endl;
+}
+
+struct options_t
+{
+    typedef enum
+    {
+        MODE_NONE,
+        MODE_LISP,
+        MODE_XML,
+        MODE_GRAPH,
+        MODE_DOT,
+        MODE_BINARY,
+        MODE_JSON,
+        MODE_SPLIT,
+        MODE_HELP
+    } mode_e;
+
+    mode_e      mode;
+    std::string in_xml;
+    std::string in_binary;
+    std::string in_file;
+    bool        in_stdin;
+    std::string serve_socket;
+    int         jobs;
+    std::string expr;
+    bool        dump_memory;
+    bool        skip_singleton;
+    bool        stream;
+    bool        print_stats;
+    bool        grammar_profile;
+    int         sentence_index; // position in batch input, -1 if not batching
+    std::string result_cache_dir;
+    size_t      result_cache_size;
+    std::string trace_file;
+    std::string admission;
+
+    std::vector<std::string>           reparse;
+    std::vector<natlang::SentenceEdit> edits; // from reparse
+
+    natlang::ParseOptions parse_options;
+    xl::DiskCache*        result_cache; // shared by all threads
+
+    options_t()
+        : mode(MODE_NONE), in_stdin(false), jobs(1), dump_memory(false), skip_singleton(false), stream(false),
+          print_stats(false), grammar_profile(false), sentence_index(-1), result_cache_size(RESULT_CACHE_SIZE),
+          result_cache(NULL)
+    {}
+};
+
+bool extract_options_from_args(options_t* options, int argc, char** argv)
+{
+    if(!options)
+        return false;
+    int opt = 0;
+    int longIndex = 0;
+    static const char *optString = "i:B:f:rL:J:T:P:M:A:a:C:Z:E:e:R:lxgdbjwsSmtGh?";
+    static const struct option longOpts[] = {
+                { "in-xml",         required_argument, NULL, 'i' },
+                { "in-binary",      required_argument, NULL, 'B' },
+                { "in-file",        required_argument, NULL, 'f' },
+                { "stdin",          no_argument,       NULL, 'r' },
+                { "serve",          required_argument, NULL, 'L' },
+                { "jobs",           required_argument, NULL, 'J' },
+                { "max-seconds",    required_argument, NULL, 'T' },
+                { "max-paths",      required_argument, NULL, 'P' },
+                { "max-bytes",      required_argument, NULL, 'M' },
+                { "max-estimated-paths", required_argument, NULL, 'A' },
+                { "admission",      required_argument, NULL, 'a' },
+                { "result-cache",      required_argument, NULL, 'C' },
+                { "result-cache-size", required_argument, NULL, 'Z' },
+                { "trace",          required_argument, NULL, 'E' },
+                { "expr",           required_argument, NULL, 'e' },
+                { "reparse",        required_argument, NULL, 'R' },
+                { "lisp",           no_argument,       NULL, 'l' },
+                { "xml",            no_argument,       NULL, 'x' },
+                { "graph",          no_argument,       NULL, 'g' },
+                { "dot",            no_argument,       NULL, 'd' },
+                { "binary",         no_argument,       NULL, 'b' },
+                { "json",           no_argument,       NULL, 'j' },
+                { "split",          no_argument,       NULL, 'w' },
+                { "skip_singleton", no_argument,       NULL, 's' },
+                { "stream",         no_argument,       NULL, 'S' },
+                { "memory",         no_argument,       NULL, 'm' },
+                { "stats",          no_argument,       NULL, 't' },
+                { "grammar-profile", no_argument,      NULL, 'G' },
+                { "help",           no_argument,       NULL, 'h' },
+                { NULL,             no_argument,       NULL, 0 }
+            };
+    opt = getopt_long(argc, argv, optString, longOpts, &longIndex);
+    while(opt != -1)
+    {
+        switch(opt)
+        {
+            case 'i': options->in_xml = optarg; break;
+            case 'B': options->in_binary = optarg; break;
+            case 'f': options->in_file = optarg; break;
+            case 'r': options->in_stdin = true; break;
+            case 'L': options->serve_socket = optarg; break;
+            case 'J': options->jobs = std::max(1, atoi(optarg)); break;
+            case 'T': options->parse_options.max_seconds = atof(optarg); break;
+            case 'P': options->parse_options.max_paths = strtoul(optarg, NULL, 10); break;
+            case 'M': options->parse_options.max_bytes = strtoul(optarg, NULL, 10); break;
+            case 'A': options->parse_options.max_estimated_paths = strtoul(optarg, NULL, 10); break;
+            case 'a': options->admission = optarg; break;
+            case 'C': options->result_cache_dir = optarg; break;
+            case 'Z': options->result_cache_size = strtoul(optarg, NULL, 10); break;
+            case 'E': options->trace_file = optarg; break;
+            case 'e': options->expr = optarg; break;
+            case 'R': options->reparse.push_back(optarg); break;
+            case 'l': options->mode = options_t::MODE_LISP; break;
+            case 'x': options->mode = options_t::MODE_XML; break;
+            case 'g': options->mode = options_t::MODE_GRAPH; break;
+            case 'd': options->mode = options_t::MODE_DOT; break;
+            case 'b': options->mode = options_t::MODE_BINARY; break;
+            case 'j': options->mode = options_t::MODE_JSON; break;
+            case 'w': options->mode = options_t::MODE_SPLIT; break;
+            case 's': options->skip_singleton = true; break;
+            case 'S': options->stream = true; break;
+            case 'm': options->dump_memory = true; break;
+            case 't': options->print_stats = true; break;
+            case 'G': options->grammar_profile = true; break;
+            case 'h':
+            case '?': options->mode = options_t::MODE_HELP; break;
+            case 0: // reserved
+            default:
+                break;
+        }
+        opt = getopt_long(argc, argv, optString, longOpts, &longIndex);
+    }
+    return options->mode != options_t::MODE_NONE || options->dump_memory;
+}
+
+static void print_json_record(
+        const natlang::Interpretation        &interpretation,
+        xl::visitor::Filterable::filter_cb_t  filter_cb,
+        int                                   sentence_index,
+        std::ostream                         &os)
+{
+    os << '{';
+    if(sentence_index >= 0)
+        os << "\"sentence_index\":" << sentence_index << ',';
+    os << "\"path_index\":" << interpretation.m_path_index << ",\"pos_path\":[";
+    const std::vector<std::string> &pos_value_path = interpretation.m_pos_value_path;
+    for(auto p = pos_value_path.begin(); p != pos_value_path.end(); p++)
+    {
+        if(p != pos_value_path.begin())
+            os << ',';
+        xl::visitor::JsonPrinter::print_string(os, *p);
+    }
+    os << "],\"tree\":";
+    xl::mvc::MVCView::print_json(interpretation.m_ast, filter_cb, os);
+    os << "}\n";
+}
+
+bool export_ast(
+        options_t                     &options,
+        const natlang::Interpretation &interpretation,
+        std::ostream                  &os,
+        int                            export_index,
+        double*                        annotate_seconds = NULL)
+{
+    xl::node::NodeIdentIFace* ast = interpretation.m_ast;
+    if(!ast)
+        return false;
+    const std::vector<std::string> &pos_value_path = interpretation.m_pos_value_path;
+    std::string pos_value_path_str;
+    for(auto p = pos_value_path.begin(); p != pos_value_path.end(); p++)
+        pos_value_path_str.append(*p + " ");
+    std::stringstream ss;
+    ss << "INFO: export path #" <<
+            interpretation.m_path_index <<
+            ": <" << pos_value_path_str << ">" << std::endl;
+    std::cerr << ss.str(); // in one piece, since workers share stderr
+    xl::visitor::Filterable::filter_cb_t filter_cb = NULL;
+    if(options.skip_singleton)
+    {
+        filter_cb = filter_singleton;
+        if(options.mode == options_t::MODE_GRAPH || options.mode == options_t::MODE_DOT ||
+                options.mode == options_t::MODE_BINARY)
+        {
+            std::cerr << "ERROR: \"skip_singleton\" not supported for this mode!" << std::endl;
+            return false;
+        }
+        double start_time = xl::system::monotonic_seconds();
+        xl::trace::Span span("annotate_tree", "output");
+        xl::mvc::MVCView::annotate_tree(ast); // filter_singleton needs height
+        if(annotate_seconds)
+            *annotate_seconds += xl::system::monotonic_seconds()-start_time;
+    }
+    #ifdef DEBUG
+        xl::mvc::MVCView::annotate_tree(ast); // printers dump annotations
+    #endif
+    switch(options.mode)
+    {
+        case options_t::MODE_LISP:  xl::mvc::MVCView::print_lisp(ast, filter_cb, os); break;
+        case options_t::MODE_XML:   xl::mvc::MVCView::print_xml(ast, filter_cb, os); break;
+        case options_t::MODE_GRAPH: xl::mvc::MVCView::print_graph(ast, os, export_index); break;
+        case options_t::MODE_DOT:   xl::mvc::MVCView::print_dot(ast, false, false, os); break;
+        case options_t::MODE_BINARY: xl::mvc::MVCView::print_binary(ast, os); break;
+        case options_t::MODE_JSON:  print_json_record(interpretation, filter_cb, options.sentence_index, os); break;
+        default:
+            break;
+    }
+    return true;
+}
+
+bool import_xml(
+        options_t                            &options,
+        xl::Allocator                        &alloc,
+        std::vector<natlang::Interpretation>* interpretations)
+{
+    std::ifstream file(options.in_xml.c_str());
+    if(!file.is_open())
+    {
+        std::cerr << "ERROR: cannot open \"" << options.in_xml << "\"!" << std::endl;
+        return false;
+    }
+    xl::TreeContext* tc = new (PNEW(alloc, xl::, TreeContext)) xl::TreeContext(alloc);
+    xl::XMLReader reader(file);
+    std::vector<std::string> empty_pos_value_path;
+    int path_index = 0;
+    for(;;)
+    {
+        xl::node::NodeIdentIFace* _ast = xl::mvc::MVCModel::make_ast(tc, reader);
+        if(!_ast)
+        {
+            if(reader.eof())
+                break;
+            std::cerr << "ERROR: de-serialize from xml fail! (line " << reader.line() << ")" << std::endl;
+            return false;
+        }
+        interpretations->push_back(natlang::Interpretation(path_index, empty_pos_value_path, _ast));
+        path_index++;
+    }
+    return true;
+}
+
+bool import_binary(
+        options_t                            &options,
+        xl::Allocator                        &alloc,
+        std::vector<natlang::Interpretation>* interpretations)
+{
+    xl::MappedFile file(options.in_binary);
+    if(!file.is_open())
+    {
+        std::cerr << "ERROR: cannot open \"" << options.in_binary << "\"!" << std::endl;
+        return false;
+    }
+    std::vector<std::string> empty_pos_value_path;
+    int path_index = 0;
+    for(size_t offset = 0; offset < file.size();)
+    {
+        xl::binary::TreeView view(file.data()+offset, file.size()-offset);
+        xl::node::NodeIdentIFace* _ast = xl::mvc::MVCModel::make_ast(
+                new (PNEW(alloc, xl::, TreeContext)) xl::TreeContext(alloc),
+                view);
+        if(!_ast)
+        {
+            std::cerr << "ERROR: de-serialize from binary fail!" << std::endl;
+            return false;
+        }
+        interpretations->push_back(natlang::Interpretation(path_index, empty_pos_value_path, _ast));
+        path_index++;
+        offset += view.block_size();
+    }
+    return true;
+}
+
+// cached results depend only on the sentence and what shapes its parses;
+// output options are applied when a cached result is exported
+static std::string result_cache_key(const options_t &options)
+{
+    std::string sentence;
+    std::vector<token_view_t> tokens;
+    normalize_sentence(options.expr + " .", &sentence, &tokens, options.parse_options.expand_contractions);
+    std::stringstream ss;
+    ss << natlang::Parser::build_id() << '\n' << options.parse_options.expand_contractions << '\n' << sentence;
+    return ss.str();
+}
+
+// a cache entry holds one record per interpretation: its path index and
+// POS path on a line, padding, then the tree in binary
+static void append_cache_record(std::string* entry, const natlang::Interpretation &interpretation)
+{
+    std::stringstream ss;
+    ss << interpretation.m_path_index;
+    const std::vector<std::string> &pos_value_path = interpretation.m_pos_value_path;
+    for(auto p = pos_value_path.begin(); p != pos_value_path.end(); p++)
+        ss << ' ' << *p;
+    ss << '\n';
+    entry->append(ss.str());
+    entry->append((RESULT_CACHE_ALIGN-entry->size()%RESULT_CACHE_ALIGN)%RESULT_CACHE_ALIGN, '\n');
+    std::stringstream tree;
+    xl::binary::write_tree(tree, interpretation.m_ast);
+    entry->append(tree.str());
+}
+
+static bool import_cache_entry(
+        const std::string                    &entry,
+        xl::Allocator                        &alloc,
+        std::vector<natlang::Interpretation>* interpretations)
+{
+    for(size_t offset = 0; offset < entry.size();)
+    {
+        size_t end_of_line = entry.find('\n', offset);
+        if(end_of_line == std::string::npos)
+            return false;
+        std::stringstream ss(entry.substr(offset, end_of_line-offset));
+        int path_index = 0;
+        if(!(ss >> path_index))
+            return false;
+        std::vector<std::string> pos_value_path;
+        std::string pos_value;
+        while(ss >> pos_value)
+            pos_value_path.push_back(pos_value);
+        offset = (end_of_line+1+RESULT_CACHE_ALIGN-1)/RESULT_CACHE_ALIGN*RESULT_CACHE_ALIGN;
+        if(offset >= entry.size())
+            return false;
+        xl::binary::TreeView view(entry.data()+offset, entry.size()-offset);
+        if(!view.is_valid())
+            return false;
+        xl::node::NodeIdentIFace* _ast = xl::mvc::MVCModel::make_ast(
+                new (PNEW(alloc, xl::, TreeContext)) xl::TreeContext(alloc),
+                view);
+        if(!_ast)
+            return false;
+        interpretations->push_back(natlang::Interpretation(path_index, pos_value_path, _ast));
+        offset += view.block_size();
+    }
+    return true;
+}
+
+struct export_context_t
+{
+    options_t    &m_options;
+    std::ostream &m_os;
+    int           m_export_index;
+    std::string*  m_cache_entry; // trees are freed after export, so they are cached as they go
+    double        m_annotate_seconds;
+    double        m_export_seconds; // including m_annotate_seconds
+
+    export_context_t(options_t &options, std::ostream &os)
+        : m_options(options), m_os(os), m_export_index(0), m_cache_entry(NULL), m_annotate_seconds(0),
+          m_export_seconds(0)
+    {}
+    void export_tree(const natlang::Interpretation &interpretation)
+    {
+        double start_time = xl::system::monotonic_seconds();
+        xl::trace::Span span("export", "output");
+        span.arg("path_index", interpretation.m_path_index);
+        if(export_ast(m_options, interpretation, m_os, m_export_index, &m_annotate_seconds))
+            m_export_index++;
+        m_export_seconds += xl::system::monotonic_seconds()-start_time;
+    }
+};
+
+static bool export_interpretation(const natlang::Interpretation &interpretation, void* context)
+{
+    export_context_t* export_context = static_cast<export_context_t*>(context);
+    if(export_context->m_cache_entry)
+        append_cache_record(export_context->m_cache_entry, interpretation);
+    export_context->export_tree(interpretation);
+    export_context->m_os.flush(); // hand out each result as soon as it exists
+    return true;
+}
+
+static void print_sentence_delimiter(std::ostream &os, ParseBudget::status_e status)
+{
+    os << SENTENCE_DELIMITER;
+    if(status != ParseBudget::STATUS_OK)
+        os << ParseBudget::status_name(status);
+    os << '\n';
+}
+
+static long to_us(double seconds)
+{
+    return static_cast<long>(seconds*1e6+0.5);
+}
+
+// one JSON line per sentence when batching, a readable report otherwise;
+// parse counters are zero for sentences that came from a cache or an import
+static void print_sentence_stats(
+        const options_t            &options,
+        const natlang::ParseResult &parse_result,
+        const export_context_t     &export_context,
+        const char*                 source)
+{
+    const natlang::ParseStats &stats = parse_result.stats();
+    size_t word_count = parse_result.word_count();
+    size_t parsed_count = parse_result.path_count()-parse_result.reused_count();
+    long export_us = to_us(export_context.m_export_seconds-export_context.m_annotate_seconds);
+    std::stringstream ss;
+    if(options.sentence_index >= 0)
+    {
+        ss << "{\"sentence_index\":" << options.sentence_index
+           << ",\"source\":\"" << source << '"'
+           << ",\"words\":" << word_count << ",\"pos_options\":[";
+        for(size_t i = 0; i<word_count; i++)
+            ss << (i ? "," : "") << parse_result.pos_option_count(i);
+        ss << "],\"estimated_paths\":" << stats.m_estimated_path_count
+           << ",\"trimmed_pos_options\":" << stats.m_trimmed_option_count
+           << ",\"paths\":" << stats.m_enumerated_path_count
+           << ",\"paths_parsed\":" << parsed_count
+           << ",\"paths_accepted\":" << parse_result.parse_count()
+           << ",\"lookup_us\":" << to_us(stats.m_lookup_seconds)
+           << ",\"enumeration_us\":" << to_us(stats.m_enumeration_seconds)
+           << ",\"make_ast_us\":" << to_us(stats.m_parse_seconds)
+           << ",\"annotate_tree_us\":" << to_us(export_context.m_annotate_seconds)
+           << ",\"export_us\":" << export_us
+           << ",\"allocator_peak_bytes\":" << stats.m_peak_bytes
+           << ",\"interned_strings\":" << stats.m_unique_string_count << "}\n";
+    }
+    else
+    {
+        ss << "STATS: source " << source << std::endl
+           << "STATS: words " << word_count << " (POS options";
+        for(size_t i = 0; i<word_count; i++)
+            ss << ' ' << parse_result.pos_option_count(i);
+        ss << ')' << std::endl
+           << "STATS: estimated paths " << stats.m_estimated_path_count
+           << " (trimmed " << stats.m_trimmed_option_count << " POS options)" << std::endl
+           << "STATS: paths " << stats.m_enumerated_path_count
+           << " (parsed " << parsed_count << ", accepted " << parse_result.parse_count() << ')' << std::endl
+           << "STATS: lookup " << to_us(stats.m_lookup_seconds) << " us"
+           << ", enumeration " << to_us(stats.m_enumeration_seconds) << " us"
+           << ", make_ast " << to_us(stats.m_parse_seconds) << " us"
+           << ", annotate_tree " << to_us(export_context.m_annotate_seconds) << " us"
+           << ", export " << export_us << " us" << std::endl
+           << "STATS: allocator peak " << stats.m_peak_bytes << " bytes"
+           << ", " << stats.m_unique_string_count << " interned strings" << std::endl;
+    }
+    std::cerr << ss.str(); // in one piece, since workers share stderr
+}
+
+// names the words that made the sentence too expensive, with how many POS
+// options each has left
+static void print_estimate_warning(const natlang::ParseResult &parse_result)
+{
+    std::stringstream ss;
+    ss << "WARNING: estimated " << parse_result.stats().m_estimated_path_count << " paths";
+    if(parse_result.stats().m_trimmed_option_count)
+        ss << ", trimmed " << parse_result.stats().m_trimmed_option_count << " POS options";
+    ss << "; most ambiguous words:";
+    std::vector<size_t> word_indices = parse_result.costliest_words(REPORTED_WORD_COUNT);
+    for(auto p = word_indices.begin(); p != word_indices.end(); p++)
+        ss << ' ' << parse_result.word(*p) << '(' << parse_result.pos_option_count(*p) << ')';
+    ss << std::endl;
+    std::cerr << ss.str(); // in one piece, since workers share stderr
+}
+
+// "insert INDEX WORD...", "delete INDEX COUNT" or "replace INDEX COUNT WORD..."
+static bool parse_sentence_edit(const std::string &s, std::vector<natlang::SentenceEdit>* edits)
+{
+    std::stringstream ss(s);
+    std::string type_name;
+    size_t word_index = 0;
+    size_t count = 0;
+    if(!(ss >> type_name >> word_index))
+        return false;
+    natlang::SentenceEdit::type_e type;
+    if(type_name == "insert")
+        type = natlang::SentenceEdit::INSERT;
+    else if(type_name == "delete")
+        type = natlang::SentenceEdit::DELETE;
+    else if(type_name == "replace")
+        type = natlang::SentenceEdit::REPLACE;
+    else
+        return false;
+    if(type != natlang::SentenceEdit::INSERT && !(ss >> count))
+        return false;
+    std::vector<std::string> words;
+    std::string word;
+    while(ss >> word)
+        words.push_back(word);
+    if((type == natlang::SentenceEdit::DELETE) != words.empty())
+        return false;
+    edits->push_back(natlang::SentenceEdit(type, word_index, count, words));
+    return true;
+}
+
+bool apply_options_to_sentence(
+        options_t             &options,
+        natlang::Parser       &parser,
+        std::ostream          &os,
+        ParseBudget::status_e* status = NULL)
+{
+    xl::trace::Span span("sentence", "pipeline");
+    span.arg("sentence_index", options.sentence_index);
+    bool imported = options.in_xml.size() || options.in_binary.size();
+    xl::Allocator alloc(__FILE__); // holds imported trees
+    natlang::ParseResult parse_result;
+    std::vector<natlang::Interpretation> interpretations;
+    std::string cache_key;
+    std::string cache_entry;
+    bool cached = false;
+    if(!imported && options.result_cache && options.edits.empty())
+    {
+        cache_key = result_cache_key(options);
+        if(options.result_cache->lookup(cache_key, &cache_entry))
+        {
+            cached = import_cache_entry(cache_entry, alloc, &interpretations);
+            if(!cached)
+                interpretations.clear(); // unreadable, so parse again and replace it
+        }
+        cache_entry.clear();
+    }
+    bool stream = !imported && !cached && options.edits.empty() &&
+            (options.stream || options.mode == options_t::MODE_JSON);
+    if(imported)
+    {
+        bool result = false;
+        try
+        {
+            result = options.in_xml.size() ?
+                    import_xml(options, alloc, &interpretations) :
+                    import_binary(options, alloc, &interpretations);
+        }
+        catch(const char* s)
+        {
+            std::cerr << "ERROR: " << s << std::endl;
+        }
+        if(!result)
+            return false;
+    }
+    else if(!cached && !stream)
+    {
+        parse_result = parser.parse(options.expr, options.parse_options);
+        for(auto p = options.edits.begin(); p != options.edits.end(); p++)
+            parse_result = parser.reparse(parse_result, *p, options.parse_options); // each edit builds on the last
+        interpretations = parse_result.interpretations();
+        if(cache_key.size())
+        {
+            for(auto p = interpretations.begin(); p != interpretations.end(); p++)
+                append_cache_record(&cache_entry, *p);
+        }
+    }
+    export_context_t export_context(options, os);
+    if(stream && cache_key.size())
+        export_context.m_cache_entry = &cache_entry;
+    if(options.mode == options_t::MODE_DOT)
+        xl::mvc::MVCView::print_dot_header(false, os);
+    if(stream)
+        parse_result = parser.parse(options.expr, export_interpretation, &export_context, options.parse_options);
+    else
+    {
+        for(auto p = interpretations.begin(); p != interpretations.end(); p++)
+            export_context.export_tree(*p);
+    }
+    if(options.mode == options_t::MODE_DOT)
+        xl::mvc::MVCView::print_dot_footer(os);
+    if(!imported && !cached && !parse_result.ok() && !parse_result.partial() && parse_result.error().size())
+    {
+        std::stringstream ss;
+        ss << "ERROR: " << parse_result.error() << std::endl;
+        std::cerr << ss.str(); // in one piece, since workers share stderr
+    }
+    if(parse_result.partial())
+    {
+        const char* status_name = ParseBudget::status_name(parse_result.status());
+        std::cerr << "WARNING: partial result (" << status_name << ")" << std::endl;
+        if(parse_result.status() == ParseBudget::STATUS_ESTIMATE_LIMIT)
+            print_estimate_warning(parse_result);
+        if(options.mode == options_t::MODE_JSON)
+        {
+            os << '{';
+            if(options.sentence_index >= 0)
+                os << "\"sentence_index\":" << options.sentence_index << ',';
+            os << "\"status\":\"" << status_name << "\"}\n";
+        }
+    }
+    if(cache_key.size() && !cached && !parse_result.partial()) // partial results depend on timing
+        options.result_cache->store(cache_key, cache_entry);
+    if(status)
+        *status = parse_result.status();
+    if(options.print_stats)
+    {
+        print_sentence_stats(options, parse_result, export_context,
+                imported ? "import" : (cached ? "cache" : "parse"));
+    }
+    if(options.dump_memory)
+        ((imported || cached) ? alloc : parse_result.alloc()).dump(std::string(1, '\t'), os); // in order with the trees
+    return true;
+}
+
+static bool apply_options_to_batch_sentence(options_t &options, natlang::Parser &parser, std::ostream &os)
+{
+    ParseBudget::status_e status = ParseBudget::STATUS_OK;
+    bool result = apply_options_to_sentence(options, parser, os, &status);
+    if(options.mode != options_t::MODE_JSON && options.mode != options_t::MODE_BINARY)
+        print_sentence_delimiter(os, status);
+    return result;
+}
+
+// parses batch sentences on a pool of workers, each with its own output
+// buffer; a reorder buffer keeps output in input order, and at most
+// m_window sentences are in flight, so memory stays bounded
+class SentencePipeline
+{
+public:
+    SentencePipeline(options_t &options, natlang::Parser &parser, std::ostream &os, int jobs)
+        : m_options(options), m_parser(parser), m_os(os), m_window(jobs*4), m_next_push(0), m_next_write(0),
+          m_closing(false), m_result(true)
+    {
+        for(int i = 0; i < jobs; i++)
+            m_workers.push_back(std::thread(&SentencePipeline::worker, this));
+    }
+    ~SentencePipeline()
+    {
+        finish();
+    }
+    void push(const std::string &sentence)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while(m_next_push-m_next_write >= m_window)
+        {
+            write_ready(lock);
+            if(m_next_push-m_next_write >= m_window)
+                m_done_cv.wait(lock);
+        }
+        m_queue.push_back(work_t(m_next_push++, sentence));
+        m_work_cv.notify_one();
+        write_ready(lock);
+    }
+    bool finish()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_next_write != m_next_push)
+            {
+                write_ready(lock);
+                if(m_next_write != m_next_push)
+                    m_done_cv.wait(lock);
+            }
+            m_closing = true;
+            m_work_cv.notify_all();
+        }
+        for(auto p = m_workers.begin(); p != m_workers.end(); p++)
+            if((*p).joinable())
+                (*p).join();
+        return m_result;
+    }
+
+private:
+    typedef std::pair<long, std::string> work_t;
+    typedef std::map<long, std::pair<std::string, bool>> done_t;
+
+    options_t               m_options;
+    natlang::Parser        &m_parser;
+    std::ostream           &m_os;
+    long                    m_window;
+    long                    m_next_push;
+    long                    m_next_write;
+    bool                    m_closing;
+    bool                    m_result;
+    std::deque<work_t>      m_queue;
+    done_t                  m_done;
+    std::mutex              m_mutex;
+    std::condition_variable m_work_cv;
+    std::condition_variable m_done_cv;
+    std::vector<std::thread> m_workers;
+
+    // writes finished sentences that are next in input order (main thread only)
+    void write_ready(std::unique_lock<std::mutex> &lock)
+    {
+        done_t::iterator p;
+        while((p = m_done.find(m_next_write)) != m_done.end())
+        {
+            std::string s;
+            s.swap((*p).second.first);
+            m_result &= (*p).second.second;
+            m_done.erase(p);
+            lock.unlock();
+            m_os << s;
+            m_os.flush();
+            lock.lock();
+            m_next_write++;
+        }
+    }
+    void worker()
+    {
+        xl::trace::set_thread_name("worker");
+        options_t options = m_options;
+        long first_sentence_index = options.sentence_index+1;
+        xl::StringSink sink;
+        std::ostream os(&sink);
+        for(;;)
+        {
+            work_t work;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while(m_queue.empty() && !m_closing)
+                    m_work_cv.wait(lock);
+                if(m_queue.empty())
+                    return;
+                work = m_queue.front();
+                m_queue.pop_front();
+            }
+            options.expr = work.second;
+            options.sentence_index = first_sentence_index+work.first;
+            bool result = apply_options_to_batch_sentence(options, m_parser, os);
+            std::string s = sink.str();
+            sink.clear();
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done[work.first] = std::make_pair(s, result);
+            m_done_cv.notify_one();
+        }
+    }
+};
+
+static bool apply_options_to_buffer(
+        options_t         &options,
+        natlang::Parser   &parser,
+        std::ostream      &os,
+        const char*        buf,
+        size_t             n,
+        bool               at_eof,
+        size_t*            consumed,
+        SentencePipeline*  pipeline = NULL)
+{
+    bool result = true;
+    SentenceSplitter sentence_splitter(buf, n);
+    std::string sentence;
+    while(sentence_splitter.next(&sentence, at_eof))
+    {
+        if(options.mode == options_t::MODE_SPLIT)
+        {
+            os << sentence << '\n';
+            continue;
+        }
+        if(pipeline)
+        {
+            pipeline->push(sentence);
+            continue;
+        }
+        options.expr = sentence;
+        options.sentence_index++;
+        result &= apply_options_to_batch_sentence(options, parser, os);
+        os.flush(); // one write per sentence
+    }
+    if(consumed)
+        *consumed = sentence_splitter.remaining()-buf;
+    return result;
+}
+
+struct server_stats_t
+{
+    std::atomic<long> m_open_connections;
+    std::atomic<long> m_total_connections;
+    std::atomic<long> m_requests;
+    std::atomic<long> m_failed_requests;
+    std::atomic<long> m_partial_requests;
+    time_t            m_start_time;
+};
+static server_stats_t server_stats;
+
+static void print_server_stats(natlang::Parser &parser, std::ostream &os)
+{
+    size_t pos_cache_size   = 0;
+    size_t pos_cache_hits   = 0;
+    size_t pos_cache_misses = 0;
+    parser.pos_cache().stats(&pos_cache_size, &pos_cache_hits, &pos_cache_misses);
+    size_t shape_cache_size   = 0;
+    size_t shape_cache_hits   = 0;
+    size_t shape_cache_misses = 0;
+    parser.shape_cache().stats(&shape_cache_size, &shape_cache_hits, &shape_cache_misses);
+    os << "{\"uptime\":" << (time(NULL)-server_stats.m_start_time)
+       << ",\"open_connections\":" << server_stats.m_open_connections
+       << ",\"total_connections\":" << server_stats.m_total_connections
+       << ",\"requests\":" << server_stats.m_requests
+       << ",\"failed_requests\":" << server_stats.m_failed_requests
+       << ",\"partial_requests\":" << server_stats.m_partial_requests
+       << ",\"pos_cache_size\":" << pos_cache_size
+       << ",\"pos_cache_hits\":" << pos_cache_hits
+       << ",\"pos_cache_misses\":" << pos_cache_misses
+       << ",\"shape_cache_size\":" << shape_cache_size
+       << ",\"shape_cache_hits\":" << shape_cache_hits
+       << ",\"shape_cache_misses\":" << shape_cache_misses << "}\n";
+}
+
+// connection threads hold the parser, so they are joined rather than detached
+struct serve_connection_t
+{
+    std::thread       m_thread;
+    std::atomic<bool> m_done;
+
+    serve_connection_t()
+        : m_done(false)
+    {}
+};
+
+// answers each line with its parses followed by SENTENCE_DELIMITER; only the
+// parser's POS and shape caches carry over between requests, since each
+// parse has its own allocator and interned strings
+static void serve_connection(options_t options, natlang::Parser* parser, int fd, std::atomic<bool>* done)
+{
+    xl::FdSink sink(fd);
+    std::ostream os(&sink);
+    std::string pending;
+    char buf[4096];
+    for(;;)
+    {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            break;
+        pending.append(buf, n);
+        size_t begin = 0;
+        size_t end = 0;
+        while((end = pending.find('\n', begin)) != std::string::npos)
+        {
+            std::string line = pending.substr(begin, end-begin);
+            begin = end+1;
+            if(line.size() && *line.rbegin() == '\r')
+                line.erase(line.size()-1);
+            ParseBudget::status_e status = ParseBudget::STATUS_OK;
+            if(line == SERVE_STATS_REQUEST)
+                print_server_stats(*parser, os);
+            else
+            {
+                server_stats.m_requests++;
+                options.expr = line;
+                if(!apply_options_to_sentence(options, *parser, os, &status))
+                    server_stats.m_failed_requests++;
+                if(status != ParseBudget::STATUS_OK)
+                    server_stats.m_partial_requests++;
+            }
+            print_sentence_delimiter(os, status);
+            os.flush();
+        }
+        pending.erase(0, begin);
+        if(pending.size() > SERVE_MAX_LINE_SIZE)
+        {
+            std::cerr << "ERROR: request line too long, closing connection" << std::endl;
+            break;
+        }
+    }
+    close(fd);
+    server_stats.m_open_connections--;
+    *done = true;
+}
+
+static bool serve(options_t &options, natlang::Parser &parser)
+{
+    if(options.in_file.size() || options.in_stdin || options.in_xml.size() || options.in_binary.size() ||
+            options.mode == options_t::MODE_BINARY || options.mode == options_t::MODE_SPLIT)
+    {
+        std::cerr << "ERROR: mode not supported for \"serve\"!" << std::endl;
+        return false;
+    }
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(options.serve_socket.size() >= sizeof(addr.sun_path))
+    {
+        std::cerr << "ERROR: socket path too long" << std::endl;
+        return false;
+    }
+    strcpy(addr.sun_path, options.serve_socket.c_str());
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listen_fd == -1)
+    {
+        perror("socket");
+        return false;
+    }
+    unlink(addr.sun_path);
+    if(bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 ||
+            listen(listen_fd, SOMAXCONN) == -1)
+    {
+        perror("bind");
+        close(listen_fd);
+        return false;
+    }
+    signal(SIGPIPE, SIG_IGN); // a client hanging up must not take down the server
+    server_stats.m_start_time = time(NULL);
+    std::cerr << "INFO: serving on " << options.serve_socket << std::endl;
+    std::list<serve_connection_t> connections;
+    for(;;)
+    {
+        int fd = accept(listen_fd, NULL, NULL);
+        if(fd == -1)
+        {
+            if(errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if(errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+            {
+                usleep(SERVE_RETRY_US); // until connections close
+                continue;
+            }
+            perror("accept");
+            break;
+        }
+        for(auto p = connections.begin(); p != connections.end();)
+        {
+            if(!(*p).m_done)
+            {
+                p++;
+                continue;
+            }
+            (*p).m_thread.join();
+            p = connections.erase(p);
+        }
+        server_stats.m_open_connections++;
+        server_stats.m_total_connections++;
+        connections.emplace_back();
+        serve_connection_t &connection = connections.back();
+        connection.m_thread = std::thread(serve_connection, options, &parser, fd, &connection.m_done);
+    }
+    for(auto p = connections.begin(); p != connections.end(); p++)
+        (*p).m_thread.join(); // the parser must outlive them
+    close(listen_fd);
+    unlink(addr.sun_path);
+    return false;
+}
+
+bool apply_options(options_t &options)
+{
+    if(options.mode == options_t::MODE_HELP)
+    {
+        display_usage(true);
+        return true;
+    }
+    if(options.expr.empty() && options.in_xml.empty() && options.in_binary.empty() &&
+            options.in_file.empty() && !options.in_stdin && options.serve_socket.empty())
+    {
+        std::cerr << "ERROR: mode not supported!" << std::endl;
+        return false;
+    }
+    natlang::Parser parser; // caches stay warm for the whole run
+    std::unique_ptr<xl::DiskCache> result_cache;
+    if(options.result_cache_dir.size())
+    {
+        result_cache.reset(new xl::DiskCache(options.result_cache_dir, options.result_cache_size));
+        if(!result_cache->is_open())
+        {
+            std::cerr << "ERROR: cannot use \"" << options.result_cache_dir << "\" as a result cache" << std::endl;
+            return false;
+        }
+        options.result_cache = result_cache.get();
+    }
+    if(options.admission.size())
+    {
+        if(options.admission == "reject")
+            options.parse_options.admission = natlang::ParseOptions::ADMISSION_REJECT;
+        else if(options.admission == "first")
+            options.parse_options.admission = natlang::ParseOptions::ADMISSION_FIRST;
+        else if(options.admission == "trim")
+            options.parse_options.admission = natlang::ParseOptions::ADMISSION_TRIM;
+        else
+        {
+            std::cerr << "ERROR: unknown admission policy \"" << options.admission << "\"!" << std::endl;
+            return false;
+        }
+    }
+    GrammarProfile grammar_profile;
+    if(options.grammar_profile)
+    {
+        if(options.serve_socket.size())
+        {
+            std::cerr << "ERROR: \"grammar-profile\" not supported for \"serve\"!" << std::endl;
+            return false;
+        }
+        if(options.result_cache)
+            std::cerr << "WARNING: cached sentences are left out of the grammar profile" << std::endl;
+        options.parse_options.grammar_profile = &grammar_profile;
+    }
+    if(options.trace_file.size())
+    {
+        if(options.serve_socket.size())
+        {
+            std::cerr << "ERROR: \"trace\" not supported for \"serve\"!" << std::endl;
+            return false;
+        }
+        xl::trace::enable();
+        xl::trace::set_thread_name("main");
+    }
+    if(options.reparse.size())
+    {
+        if(options.expr.empty() || options.in_xml.size() || options.in_binary.size() || options.in_file.size() ||
+                options.in_stdin || options.serve_socket.size())
+        {
+            std::cerr << "ERROR: \"reparse\" needs --expr input!" << std::endl;
+            return false;
+        }
+        for(auto p = options.reparse.begin(); p != options.reparse.end(); p++)
+        {
+            if(!parse_sentence_edit(*p, &options.edits))
+            {
+                std::cerr << "ERROR: bad edit \"" << *p << "\"!" << std::endl;
+                return false;
+            }
+        }
+    }
+    if(options.serve_socket.size())
+        return serve(options, parser);
+    if((options.in_file.size() || options.in_stdin) && (options.in_xml.size() || options.in_binary.size()))
+    {
+        std::cerr << "ERROR: batch input can't be combined with de-serialization!" << std::endl;
+        return false;
+    }
+    if(options.mode == options_t::MODE_SPLIT && options.in_file.empty() && !options.in_stdin)
+    {
+        std::cerr << "ERROR: \"split\" needs batch input!" << std::endl;
+        return false;
+    }
+    xl::FdSink sink(STDOUT_FILENO);
+    std::ostream os(&sink);
+    bool result = true;
+    SentencePipeline* pipeline = NULL;
+    if(options.jobs > 1 && (options.in_file.size() || options.in_stdin))
+        pipeline = new SentencePipeline(options, parser, os, options.jobs);
+    if(options.in_file.size())
+    {
+        xl::MappedFile file(options.in_file);
+        if(!file.is_open())
+        {
+            std::cerr << "ERROR: cannot read \"" << options.in_file << "\"" << std::endl;
+            result = false;
+        }
+        else
+            result = apply_options_to_buffer(options, parser, os, file.data(), file.size(), true, NULL, pipeline);
+    }
+    else if(options.in_stdin)
+    {
+        // only the unfinished tail of each chunk is carried over
+        std::string pending;
+        char chunk[STDIN_CHUNK_SIZE];
+        bool at_eof = false;
+        while(!at_eof)
+        {
+            std::cin.read(chunk, sizeof(chunk));
+            pending.append(chunk, std::cin.gcount());
+            at_eof = !std::cin;
+            size_t consumed = 0;
+            result &= apply_options_to_buffer(options, parser, os, pending.data(), pending.size(), at_eof,
+                    &consumed, pipeline);
+            pending.erase(0, consumed);
+        }
+    }
+    else
+    {
+        result = apply_options_to_sentence(options, parser, os);
+        os.flush(); // one write per sentence when not streaming
+    }
+    if(pipeline)
+    {
+        result &= pipeline->finish();
+        delete pipeline;
+    }
+    if(options.grammar_profile)
+        grammar_profile.print_report(std::cerr);
+    if(options.trace_file.size() && !xl::trace::write_json(options.trace_file))
+    {
+        std::cerr << "ERROR: cannot write \"" << options.trace_file << "\"" << std::endl;
+        result = false;
+    }
+    return result;
+}
+
+void add_signal_handlers()
+{
+    xl::system::add_sighandler(SIGABRT, xl::system::backtrace_sighandler);
+    xl::system::add_sighandler(SIGINT,  xl::system::backtrace_sighandler);
+    xl::system::add_sighandler(SIGSEGV, xl::system::backtrace_sighandler);
+    xl::system::add_sighandler(SIGFPE,  xl::system::backtrace_sighandler);
+    xl::system::add_sighandler(SIGBUS,  xl::system::backtrace_sighandler);
+    xl::system::add_sighandler(SIGILL,  xl::system::backtrace_sighandler);
+}
+
+int main(int argc, char** argv)
+{
+    add_signal_handlers();
+    options_t options;
+    if(!extract_options_from_args(&options, argc, argv))
+    {
+        display_usage(false);
+        return EXIT_FAILURE;
+    }
+    if(!apply_options(options))
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
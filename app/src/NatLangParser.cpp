@@ -0,0 +1,293 @@
+// NatLang
+// -- An English parser with an extensible grammar
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "NatLangParser.h" // natlang::Parser
+#include "NatLang.h" // make_ast
+#include "TryAllParses.h" // build_pos_options_table_from_tokens
+#include "SentenceNormalizer.h" // normalize_sentence
+#include "XLangSystem.h" // xl::system::monotonic_seconds
+#include "XLangTrace.h" // xl::trace::Span
+#include <list> // std::list
+#include <vector> // std::vector
+#include <string> // std::string
+#include <set> // std::set
+#include <sstream> // std::stringstream
+#include <algorithm> // std::max
+
+#ifndef NATLANG_BUILD_ID
+    #define NATLANG_BUILD_ID "unknown" // set by the Makefile
+#endif
+
+namespace natlang {
+
+const char* Parser::build_id()
+{
+    return NATLANG_BUILD_ID;
+}
+
+ParseResult Parser::parse(const std::string &sentence, const ParseOptions &options)
+{
+    return parse(sentence, NULL, NULL, options);
+}
+
+ParseResult Parser::parse(const std::string &sentence, interpretation_cb_t interpretation_cb, void* context,
+        const ParseOptions &options)
+{
+    ParseResult result;
+    ParseBudget budget(options.max_seconds, options.max_paths, options.max_bytes);
+    double start_time = xl::system::monotonic_seconds();
+    std::string s = sentence + " ."; // grammar expects an end-of-sentence token
+    normalize_sentence(s, &result.m_sentence, &result.m_tokens, options.expand_contractions);
+    build_pos_options_table_from_tokens(&result.m_pos_options_table, result.m_sentence, result.m_tokens,
+            &m_pos_cache);
+    result.m_stats.m_lookup_seconds = xl::system::monotonic_seconds()-start_time;
+    bool first_only = false;
+    if(admit(&result, options, &budget, &first_only))
+        parse_paths(&result, NULL, 0, interpretation_cb, context, &budget, options.grammar_profile, first_only);
+    return result;
+}
+
+ParseResult Parser::reparse(const ParseResult &previous, const SentenceEdit &edit, const ParseOptions &options)
+{
+    return reparse(previous, edit, NULL, NULL, options);
+}
+
+ParseResult Parser::reparse(const ParseResult &previous, const SentenceEdit &edit,
+        interpretation_cb_t interpretation_cb, void* context, const ParseOptions &options)
+{
+    ParseResult result;
+    size_t removed_count = (edit.m_type == SentenceEdit::INSERT) ? 0 : edit.m_count;
+    if(edit.m_word_index+removed_count > previous.word_count())
+    {
+        result.m_error = "edit is out of range of the sentence";
+        return result;
+    }
+    std::string s;
+    for(size_t i = 0; i<edit.m_word_index; i++)
+        s.append(previous.word(i)).append(" ");
+    if(edit.m_type != SentenceEdit::DELETE)
+    {
+        for(auto p = edit.m_words.begin(); p != edit.m_words.end(); p++)
+            s.append(*p).append(" ");
+    }
+    for(size_t i = edit.m_word_index+removed_count; i<previous.m_tokens.size(); i++) // includes the end token
+        s.append(previous.word(i)).append(" ");
+    ParseBudget budget(options.max_seconds, options.max_paths, options.max_bytes);
+    double start_time = xl::system::monotonic_seconds();
+    normalize_sentence(s, &result.m_sentence, &result.m_tokens, options.expand_contractions);
+
+    // inserted words may normalize into several tokens, so match the words
+    // the edit left alone by comparing both ends of the sentences
+    size_t n = result.m_tokens.size();
+    size_t prev_n = previous.m_tokens.size();
+    bool have_rows = (previous.m_pos_options_table.size() == prev_n) &&
+            !previous.m_stats.m_trimmed_option_count; // trimmed rows would stay trimmed
+    size_t prefix_count = 0;
+    while(prefix_count<n && prefix_count<prev_n && result.word(prefix_count) == previous.word(prefix_count))
+        prefix_count++;
+    size_t suffix_count = 0;
+    while(suffix_count<n-prefix_count && suffix_count<prev_n-prefix_count &&
+            result.word(n-1-suffix_count) == previous.word(prev_n-1-suffix_count))
+        suffix_count++;
+    result.m_pos_options_table.resize(n);
+    if(have_rows)
+    {
+        for(size_t i = 0; i<prefix_count; i++)
+            result.m_pos_options_table[i] = previous.m_pos_options_table[i];
+        for(size_t i = 0; i<suffix_count; i++)
+            result.m_pos_options_table[n-1-i] = previous.m_pos_options_table[prev_n-1-i];
+    }
+    build_pos_options_table_from_tokens(&result.m_pos_options_table, result.m_sentence, result.m_tokens,
+            &m_pos_cache);
+    result.m_stats.m_lookup_seconds = xl::system::monotonic_seconds()-start_time;
+    bool first_only = false;
+    if(admit(&result, options, &budget, &first_only))
+    {
+        parse_paths(&result, &previous, prefix_count, interpretation_cb, context, &budget,
+                options.grammar_profile, first_only);
+    }
+    return result;
+}
+
+// the path count is known from the POS options alone, so a sentence that
+// would enumerate too many paths can be turned away or made cheaper before
+// any time is spent on it; returns false if it is not to be parsed
+bool Parser::admit(ParseResult* result, const ParseOptions &options, ParseBudget* budget, bool* first_only)
+{
+    ParseStats &stats = result->m_stats;
+    stats.m_estimated_path_count = estimate_pos_path_count(result->m_pos_options_table);
+    if(!options.max_estimated_paths || stats.m_estimated_path_count <= options.max_estimated_paths)
+        return true;
+    result->m_status = ParseBudget::STATUS_ESTIMATE_LIMIT;
+    switch(options.admission)
+    {
+        case ParseOptions::ADMISSION_REJECT:
+            return false;
+        case ParseOptions::ADMISSION_FIRST:
+            budget->limit_paths(options.max_estimated_paths);
+            *first_only = true;
+            break;
+        case ParseOptions::ADMISSION_TRIM:
+            stats.m_trimmed_option_count =
+                    trim_pos_options_table(&result->m_pos_options_table, options.max_estimated_paths);
+            break;
+    }
+    return true;
+}
+
+// errors rendered as yyerror does, echoing the sentence they are found in
+static std::string render_errors(const std::string &sentence, const std::vector<syntax_error_t> &errors)
+{
+    std::stringstream ss;
+    for(auto p = errors.begin(); p != errors.end(); p++)
+        print_syntax_error(ss, sentence.c_str(), *p);
+    return ss.str();
+}
+
+// a path whose lexer ids start with a prefix that failed before still fails,
+// as long as the words under that prefix are unchanged
+static const ParseResult::failed_prefixes_t::value_type* find_failed_prefix(
+        const ParseResult::failed_prefixes_t &failed_prefixes,
+        const std::set<size_t>               &prefix_lengths,
+        const std::vector<uint32_t>          &pos_lexer_id_path)
+{
+    for(auto p = prefix_lengths.begin(); p != prefix_lengths.end() && *p <= pos_lexer_id_path.size(); p++)
+    {
+        auto q = failed_prefixes.find(std::vector<uint32_t>(pos_lexer_id_path.begin(),
+                pos_lexer_id_path.begin()+*p));
+        if(q != failed_prefixes.end())
+            return &*q;
+    }
+    return NULL;
+}
+
+void Parser::parse_paths(ParseResult* result, const ParseResult* previous, size_t unchanged_word_count,
+        interpretation_cb_t interpretation_cb, void* context, ParseBudget* budget,
+        GrammarProfile* grammar_profile, bool first_only)
+{
+    std::set<size_t> prefix_lengths;
+    if(previous)
+    {
+        for(auto p = previous->m_failed_prefixes.begin(); p != previous->m_failed_prefixes.end(); p++)
+        {
+            if((*p).first.size() <= unchanged_word_count)
+                prefix_lengths.insert((*p).first.size());
+        }
+    }
+    // sentences of plain words parse the same as any others with their lexer ids,
+    // though a profile needs the grammar to run
+    bool plain_words = !grammar_profile;
+    for(auto t = result->m_tokens.begin(); t != result->m_tokens.end() && plain_words; t++)
+        plain_words = ParseShape::is_plain_word(result->m_sentence.c_str()+(*t).m_offset, (*t).m_length);
+    ParseStats &stats = result->m_stats;
+    double start_time = xl::system::monotonic_seconds();
+    std::list<std::vector<std::string>> pos_value_paths;
+    {
+        xl::trace::Span span("enumerate_paths", "parse");
+        build_pos_value_paths_from_pos_options_table(&pos_value_paths, result->m_pos_options_table, budget);
+        span.arg("path_count", pos_value_paths.size());
+    }
+    stats.m_enumerated_path_count = pos_value_paths.size();
+    stats.m_enumeration_seconds = xl::system::monotonic_seconds()-start_time;
+    int path_index = 0;
+    for(auto p = pos_value_paths.begin(); p != pos_value_paths.end(); p++, path_index++)
+    {
+        if(!budget->check(&result->alloc()))
+            break;
+        result->m_path_count++;
+        xl::node::NodeIdentIFace* ast = NULL;
+        try
+        {
+            std::vector<uint32_t> pos_lexer_id_path;
+            remap_pos_value_path_to_pos_lexer_id_path(*p, &pos_lexer_id_path);
+            const ParseResult::failed_prefixes_t::value_type* failed_prefix =
+                    prefix_lengths.empty() ? NULL :
+                    find_failed_prefix(previous->m_failed_prefixes, prefix_lengths, pos_lexer_id_path);
+            if(failed_prefix)
+            {
+                result->m_failed_prefixes.insert(*failed_prefix);
+                result->m_error = render_errors(result->m_sentence, (*failed_prefix).second);
+                result->m_reused_count++;
+                continue;
+            }
+            int error_word_index = -1;
+            size_t unique_string_count = 0;
+            start_time = xl::system::monotonic_seconds();
+            xl::trace::Span span("make_ast", "parse");
+            span.arg("path_index", path_index);
+            std::shared_ptr<const ParseShape> shape;
+            if(plain_words)
+                shape = m_shape_cache.get(pos_lexer_id_path, budget);
+            if(shape)
+            {
+                ast = shape->instantiate(result->alloc(), result->m_sentence, result->m_tokens,
+                        &unique_string_count);
+                error_word_index = shape->error_word_index();
+            }
+            else
+            {
+                ast = make_ast(result->alloc(), result->m_sentence.c_str(), pos_lexer_id_path, budget,
+                        &error_word_index, &unique_string_count, grammar_profile);
+            }
+            span.arg("success", ast != NULL);
+            span.arg("from_shape", shape != NULL);
+            stats.m_parse_seconds += xl::system::monotonic_seconds()-start_time;
+            stats.m_unique_string_count += unique_string_count;
+            if(!ast && !budget->exceeded())
+            {
+                std::vector<syntax_error_t> errors = shape ? shape->errors(result->m_tokens) : syntax_errors();
+                result->m_error = render_errors(result->m_sentence, errors);
+
+                // an error before the last token is decided by the words up
+                // to it, so a reparse can skip paths sharing that prefix
+                if(error_word_index >= 0 && static_cast<size_t>(error_word_index)+1 < pos_lexer_id_path.size())
+                {
+                    result->m_failed_prefixes[std::vector<uint32_t>(pos_lexer_id_path.begin(),
+                            pos_lexer_id_path.begin()+error_word_index+1)] = errors;
+                }
+            }
+        }
+        catch(const char* s)
+        {
+            result->m_error = s;
+        }
+        stats.m_peak_bytes = std::max(stats.m_peak_bytes, result->alloc().size());
+        if(!ast)
+        {
+            reset_error_messages();
+            if(interpretation_cb)
+                result->alloc()._free(); // drop whatever the failed attempt allocated
+            continue;
+        }
+        result->m_parse_count++;
+        Interpretation interpretation(path_index, *p, ast);
+        bool more = !first_only;
+        if(!interpretation_cb)
+            result->m_interpretations.push_back(interpretation);
+        else
+        {
+            more = interpretation_cb(interpretation, context) && more;
+            result->alloc()._free(); // the tree is no longer needed
+        }
+        if(!more)
+            break;
+    }
+    if(budget->status() != ParseBudget::STATUS_OK)
+        result->m_status = budget->status(); // admission control may have set it already
+}
+
+}
@@ -0,0 +1,254 @@
+// NatLang
+// -- An English parser with an extensible grammar
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "ParseShapeCache.h" // ParseShapeCache
+#include "NatLang.h" // make_ast
+#include "mvc/XLangMVCModel.h" // mvc::MVCModel
+#include "node/XLangNode.h" // node::Node
+#include "XLangTreeContext.h" // TreeContext
+#include <vector> // std::vector
+#include <string> // std::string
+#include <sstream> // std::stringstream
+#include <algorithm> // std::lower_bound
+#include <ctype.h> // isalpha
+#include <stdlib.h> // atoi
+
+// mirrors the scanner's identifier rule ({lit_ident}|[.] in NatLang.l)
+static bool is_ident_char(char c)
+{
+    return isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '\'' || c == ',';
+}
+
+bool ParseShape::is_plain_word(const char* s, size_t n)
+{
+    if(n == 1 && *s == '.')
+        return true;
+    if(!n || !is_ident_char(*s))
+        return false;
+    for(size_t i = 1; i<n; i++)
+    {
+        if(!is_ident_char(s[i]) && !isdigit(static_cast<unsigned char>(s[i])))
+            return false;
+    }
+    return true;
+}
+
+// node locations are byte offsets of token boundaries, so each one maps to
+// the same boundary of the same word in another sentence
+static bool map_offset(
+        uint32_t                         offset,
+        const std::vector<token_view_t> &from_tokens,
+        const std::vector<token_view_t> &to_tokens,
+        uint32_t*                        mapped_offset)
+{
+    auto p = std::lower_bound(from_tokens.begin(), from_tokens.end(), offset,
+            [](const token_view_t &token, uint32_t x) { return token.m_offset+token.m_length < x; });
+    if(p == from_tokens.end())
+        return false;
+    const token_view_t &to_token = to_tokens[p-from_tokens.begin()];
+    if(offset == (*p).m_offset)
+        *mapped_offset = to_token.m_offset;
+    else if(offset == (*p).m_offset+(*p).m_length)
+        *mapped_offset = to_token.m_offset+to_token.m_length;
+    else
+        return false;
+    return true;
+}
+
+static bool map_loc(
+        YYLTYPE                          loc,
+        const std::vector<token_view_t> &from_tokens,
+        const std::vector<token_view_t> &to_tokens,
+        YYLTYPE*                         mapped_loc)
+{
+    *mapped_loc = loc;
+    return map_offset(loc.begin_offset, from_tokens, to_tokens, &mapped_loc->begin_offset) &&
+            map_offset(loc.end_offset, from_tokens, to_tokens, &mapped_loc->end_offset);
+}
+
+// placeholder words are "_<word index>"
+static int placeholder_word_index(const xl::node::NodeIdentIFace* _node)
+{
+    if(_node->type() != xl::node::NodeIdentIFace::IDENT)
+        return -1;
+    const std::string* value =
+            dynamic_cast<const xl::node::TermNodeIFace<xl::node::NodeIdentIFace::IDENT>*>(_node)->value();
+    if(!value || value->size() < 2 || (*value)[0] != '_')
+        return -1;
+    return atoi(value->c_str()+1);
+}
+
+// a template may only hold symbols and placeholder words at known locations
+static bool is_valid_template(
+        const xl::node::NodeIdentIFace*  _node,
+        const std::vector<token_view_t> &placeholder_tokens)
+{
+    if(!_node)
+        return true;
+    YYLTYPE mapped_loc;
+    if(!map_loc(dynamic_cast<const xl::node::Node*>(_node)->loc(), placeholder_tokens, placeholder_tokens,
+            &mapped_loc))
+    {
+        return false;
+    }
+    if(_node->type() == xl::node::NodeIdentIFace::SYMBOL)
+    {
+        auto symbol = dynamic_cast<const xl::node::SymbolNodeIFace*>(_node);
+        for(size_t i = 0; i<symbol->size(); i++)
+        {
+            if(!is_valid_template((*symbol)[i], placeholder_tokens))
+                return false;
+        }
+        return true;
+    }
+    int word_index = placeholder_word_index(_node);
+    return word_index >= 0 && word_index < static_cast<int>(placeholder_tokens.size());
+}
+
+std::shared_ptr<const ParseShape> ParseShape::make(const std::vector<uint32_t> &pos_lexer_id_path,
+        ParseBudget* budget)
+{
+    std::shared_ptr<ParseShape> shape(new ParseShape());
+    std::string sentence;
+    for(size_t i = 0; i<pos_lexer_id_path.size(); i++)
+    {
+        std::stringstream ss;
+        ss << '_' << i;
+        if(i)
+            sentence.append(" ");
+        shape->m_placeholder_tokens.push_back(token_view_t(sentence.size(), ss.str().size()));
+        sentence.append(ss.str());
+    }
+    shape->m_alloc.reset(new xl::Allocator(__FILE__));
+    std::vector<uint32_t> path = pos_lexer_id_path;
+    xl::node::NodeIdentIFace* ast = NULL;
+    try
+    {
+        ast = make_ast(*shape->m_alloc, sentence.c_str(), path, budget, &shape->m_error_word_index);
+    }
+    catch(const char*)
+    {
+        reset_error_messages();
+        return std::shared_ptr<const ParseShape>();
+    }
+    shape->m_errors = syntax_errors();
+    reset_error_messages();
+    if(budget && budget->exceeded())
+        return std::shared_ptr<const ParseShape>();
+    if(ast)
+    {
+        if(!is_valid_template(ast, shape->m_placeholder_tokens))
+            return std::shared_ptr<const ParseShape>();
+        shape->m_template = ast;
+        shape->m_error_word_index = -1;
+    }
+    return shape;
+}
+
+std::vector<syntax_error_t> ParseShape::errors(const std::vector<token_view_t> &tokens) const
+{
+    std::vector<syntax_error_t> errors(m_errors);
+    for(auto p = errors.begin(); p != errors.end(); p++)
+    {
+        if((*p).m_has_loc && (tokens.size() != m_placeholder_tokens.size() ||
+                !map_loc((*p).m_loc, m_placeholder_tokens, tokens, &(*p).m_loc)))
+        {
+            (*p).m_has_loc = false; // only the message carries over
+        }
+    }
+    return errors;
+}
+
+static xl::node::NodeIdentIFace* instantiate_node(
+        xl::TreeContext                 &tc,
+        const xl::node::NodeIdentIFace*  _node,
+        const std::string               &sentence,
+        const std::vector<token_view_t> &placeholder_tokens,
+        const std::vector<token_view_t> &tokens)
+{
+    if(!_node)
+        return NULL;
+    YYLTYPE loc;
+    map_loc(dynamic_cast<const xl::node::Node*>(_node)->loc(), placeholder_tokens, tokens, &loc);
+    if(_node->type() == xl::node::NodeIdentIFace::SYMBOL)
+    {
+        auto symbol = dynamic_cast<const xl::node::SymbolNodeIFace*>(_node);
+        xl::node::SymbolNode* symbol_node = xl::mvc::MVCModel::make_symbol(&tc, _node->lexer_id(), loc, 0);
+        for(size_t i = 0; i<symbol->size(); i++)
+        {
+            // built child by child, like a clone, so lists aren't flattened twice
+            xl::node::NodeIdentIFace* child =
+                    instantiate_node(tc, (*symbol)[i], sentence, placeholder_tokens, tokens);
+            symbol_node->push_back(child);
+            if(child)
+                child->set_parent(symbol_node);
+        }
+        return symbol_node;
+    }
+    const token_view_t &token = tokens[placeholder_word_index(_node)];
+    return xl::mvc::MVCModel::make_term(&tc, _node->lexer_id(), loc,
+            tc.alloc_unique_string(sentence.substr(token.m_offset, token.m_length)));
+}
+
+xl::node::NodeIdentIFace* ParseShape::instantiate(
+        xl::Allocator                   &alloc,
+        const std::string               &sentence,
+        const std::vector<token_view_t> &tokens,
+        size_t*                          unique_string_count) const
+{
+    if(!m_template || tokens.size() != m_placeholder_tokens.size())
+        return NULL;
+    xl::TreeContext tc(alloc);
+    xl::node::NodeIdentIFace* ast = instantiate_node(tc, m_template, sentence, m_placeholder_tokens, tokens);
+    if(unique_string_count)
+        *unique_string_count = tc.unique_string_count();
+    return ast;
+}
+
+std::shared_ptr<const ParseShape> ParseShapeCache::get(const std::vector<uint32_t> &pos_lexer_id_path,
+        ParseBudget* budget)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto p = m_map.find(pos_lexer_id_path);
+        if(p != m_map.end())
+        {
+            m_hits++;
+            return (*p).second;
+        }
+        m_misses++;
+    }
+    std::shared_ptr<const ParseShape> shape = ParseShape::make(pos_lexer_id_path, budget); // slow, so done unlocked
+    if(!shape)
+        return shape;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_map.size() >= m_max_size)
+        m_map.clear(); // shapes in use stay alive until released
+    m_map[pos_lexer_id_path] = shape;
+    return shape;
+}
+
+void ParseShapeCache::stats(size_t* size, size_t* hits, size_t* misses)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(size)
+        *size = m_map.size();
+    if(hits)
+        *hits = m_hits;
+    if(misses)
+        *misses = m_misses;
+}
@@ -0,0 +1,195 @@
+// NatLang
+// -- An English parser with an extensible grammar
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "SentenceNormalizer.h"
+#include <vector> // std::vector
+#include <string> // std::string
+#include <string.h> // strncmp
+#include <stddef.h> // size_t
+#ifdef __SSE2__
+    #include <emmintrin.h> // _mm_cmpeq_epi8
+#endif
+
+static inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool is_special(char c, bool expand_contractions)
+{
+    return is_space(c) || (expand_contractions && (c == ',' || c == '\''));
+}
+
+// length of the run of bytes that need no attention: not white space and,
+// when expanding, not a comma or apostrophe
+static size_t plain_run_length(const char* s, size_t n, bool expand_contractions)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i space      = _mm_set1_epi8(' ');
+    const __m128i tab        = _mm_set1_epi8('\t');
+    const __m128i newline    = _mm_set1_epi8('\n');
+    const __m128i cr         = _mm_set1_epi8('\r');
+    const __m128i comma      = _mm_set1_epi8(expand_contractions ? ',' : ' ');
+    const __m128i apostrophe = _mm_set1_epi8(expand_contractions ? '\'' : ' ');
+    for(; i+16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s+i));
+        __m128i m = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, cr)));
+        m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, apostrophe)));
+        int mask = _mm_movemask_epi8(m);
+        if(mask)
+            return i+__builtin_ctz(mask);
+    }
+#endif
+    for(; i < n; i++)
+        if(is_special(s[i], expand_contractions))
+            break;
+    return i;
+}
+
+namespace {
+
+class TokenWriter
+{
+public:
+    TokenWriter(std::string* out, std::vector<token_view_t>* tokens)
+        : m_out(out), m_tokens(tokens), m_in_token(false)
+    {}
+    void append(const char* s, size_t n)
+    {
+        if(!m_in_token)
+        {
+            if(m_out->size())
+                m_out->push_back(' ');
+            m_tokens->push_back(token_view_t(m_out->size(), 0));
+            m_in_token = true;
+        }
+        m_out->append(s, n);
+        m_tokens->back().m_length += n;
+    }
+    void end_token()
+    {
+        m_in_token = false;
+    }
+    // drops the last byte of the current token (and the token, if emptied)
+    void retract()
+    {
+        m_out->erase(m_out->size()-1);
+        if(--m_tokens->back().m_length)
+            return;
+        m_tokens->pop_back();
+        if(m_out->size())
+            m_out->erase(m_out->size()-1);
+        m_in_token = false;
+    }
+    bool ends_with(char c) const
+    {
+        return m_in_token && m_tokens->back().m_length && *m_out->rbegin() == c;
+    }
+
+private:
+    std::string*               m_out;
+    std::vector<token_view_t>* m_tokens;
+    bool                       m_in_token;
+};
+
+}
+
+void normalize_sentence(
+        const std::string         &sentence,
+        std::string*               normalized_sentence,
+        std::vector<token_view_t>* tokens,
+        bool                       expand_contractions)
+{
+    if(!normalized_sentence || !tokens)
+        return;
+    normalized_sentence->clear();
+    normalized_sentence->reserve(sentence.size()+sentence.size()/4+8);
+    tokens->clear();
+    TokenWriter writer(normalized_sentence, tokens);
+    const char* s = sentence.c_str();
+    size_t n = sentence.size();
+    for(size_t i = 0; i < n;)
+    {
+        size_t k = plain_run_length(s+i, n-i, expand_contractions);
+        if(k)
+        {
+            writer.append(s+i, k);
+            i += k;
+            if(i == n)
+                break;
+        }
+        char c = s[i];
+        if(is_space(c))
+        {
+            writer.end_token();
+            i++;
+            continue;
+        }
+        if(c == ',')
+        {
+            writer.end_token();
+            writer.append(",", 1);
+            writer.end_token();
+            i++;
+            continue;
+        }
+        // apostrophe: same rewrites, in the same precedence, as the replace
+        // chain this stage stands in for
+        const char* rest = s+i;
+        size_t rest_n = n-i;
+        if(rest_n >= 2 && rest[1] == 't' && writer.ends_with('n')) // n't -> not
+        {
+            writer.retract();
+            writer.end_token();
+            writer.append("not", 3);
+            i += 2;
+        }
+        else if(rest_n >= 3 && !strncmp(rest, "'ve", 3))
+        {
+            writer.end_token();
+            writer.append("have", 4);
+            i += 3;
+        }
+        else if(rest_n >= 2 && !strncmp(rest, "'m", 2))
+        {
+            writer.end_token();
+            writer.append("am", 2);
+            i += 2;
+        }
+        else if(rest_n >= 3 && !strncmp(rest, "'re", 3))
+        {
+            writer.end_token();
+            writer.append("are", 3);
+            i += 3;
+        }
+        else if(rest_n >= 2 && !strncmp(rest, "'s", 2))
+        {
+            writer.end_token();
+            writer.append("'s", 2);
+            i += 2;
+        }
+        else
+        {
+            writer.append("'", 1);
+            i++;
+        }
+    }
+}
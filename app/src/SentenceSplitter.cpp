@@ -0,0 +1,88 @@
+// NatLang
+// -- An English parser with an extensible grammar
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "SentenceSplitter.h"
+#include <string> // std::string
+#include <string.h> // strncasecmp
+#include <ctype.h> // isspace, isalpha
+
+static const char* abbreviations[] = {
+        "mr", "mrs", "ms", "dr", "prof", "sr", "jr", "st", "mt", "gen", "gov", "sen", "rep",
+        "vs", "etc", "e.g", "i.e", "cf", "al", "inc", "ltd", "co", "corp", "dept", "no", "approx",
+        "jan", "feb", "mar", "apr", "jun", "jul", "aug", "sep", "sept", "oct", "nov", "dec"
+        };
+
+bool SentenceSplitter::is_abbreviation(const char* word_begin, const char* period)
+{
+    size_t n = period-word_begin;
+    if(n == 1 && isalpha(static_cast<unsigned char>(*word_begin)))
+        return true; // initial
+    for(size_t i = 0; i < sizeof(abbreviations)/sizeof(*abbreviations); i++)
+        if(strlen(abbreviations[i]) == n && !strncasecmp(abbreviations[i], word_begin, n))
+            return true;
+    return false;
+}
+
+bool SentenceSplitter::next(std::string* sentence, bool at_eof)
+{
+    sentence->clear();
+    const char* p = m_pos;
+    const char* word_begin = p;
+    int newline_count = 0;
+    for(; p != m_end; p++)
+    {
+        char c = *p;
+        if(isspace(static_cast<unsigned char>(c)))
+        {
+            if(c == '\n' && ++newline_count == 2 && sentence->find_first_not_of(' ') != std::string::npos)
+            {
+                m_pos = p+1; // paragraph break
+                return true;
+            }
+            if(sentence->size() && *sentence->rbegin() != ' ')
+                sentence->push_back(' ');
+            word_begin = p+1;
+            continue;
+        }
+        newline_count = 0;
+        if(c == '.' || c == '?' || c == '!')
+        {
+            const char* q = p;
+            while(q != m_end && (*q == '.' || *q == '?' || *q == '!' || *q == '"' || *q == '\'' || *q == ')'))
+                q++;
+            if(q == m_end && !at_eof)
+                break; // can't tell yet
+            bool boundary = (q == m_end || isspace(static_cast<unsigned char>(*q))) &&
+                    !(c == '.' && q == p+1 && is_abbreviation(word_begin, p));
+            if(boundary)
+            {
+                m_pos = q;
+                if(sentence->find_first_not_of(' ') != std::string::npos)
+                    return true;
+                sentence->clear();
+                word_begin = q;
+                p = q-1;
+                continue;
+            }
+        }
+        sentence->push_back(c);
+    }
+    if(!at_eof)
+        return false;
+    m_pos = m_end;
+    return sentence->find_first_not_of(' ') != std::string::npos;
+}
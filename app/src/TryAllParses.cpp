@@ -20,14 +20,20 @@
 #include "node/XLangNodeIFace.h" // node::NodeIdentIFace
 #include "NatLangLexerIDWrapper.h" // ID_XXX (yacc generated)
 #include "XLangAlloc.h" // Allocator
-#include "XLangString.h" // xl::tokenize
-#include "XLangSystem.h" // xl::system::shell_capture
+#include "SentenceNormalizer.h" // normalize_sentence
+#include "XLangString.h" // xl::regexp
+#include "XLangSystem.h" // xl::system::exec_capture
+#include "XLangTrace.h" // xl::trace::Span
 #include <vector> // std::vector
 #include <list> // std::list
 #include <stack> // std::stack
 #include <string> // std::string
+#include <map> // std::map
+#include <set> // std::set
+#include <mutex> // std::mutex
 #include <algorithm> // std::sort
 #include <iostream> // std::cerr
+#include <sstream> // std::stringstream
 
 typedef std::vector<std::pair<std::string, int>> pos_value_faml_tuples_t;
 struct pos_value_faml_tuples_greater_than
@@ -46,8 +52,8 @@ bool get_pos_values_from_wordnet(
 {
     if(word.empty() || !pos_values)
         return false;
-    std::string which_wn_stdout = xl::system::shell_capture("which wn");
-    if(which_wn_stdout.empty())
+    static bool found_wordnet = !xl::system::shell_capture("which wn").empty(); // probe once
+    if(!found_wordnet)
     {
         std::cerr << "ERROR: WordNet not found" << std::endl;
         return false;
@@ -58,8 +64,8 @@ bool get_pos_values_from_wordnet(
     const char* pos_values_arr[]     = {"N", "V", "Adj", "Adv"};
     for(int i = 0; i<4; i++)
     {
-        std::string wordnet_stdout =
-                xl::system::shell_capture("wn \"" + word + "\" -faml" + wordnet_faml_types[i]);
+        std::vector<std::string> args = {"wn", word, std::string("-faml")+wordnet_faml_types[i]};
+        std::string wordnet_stdout = xl::system::exec_capture(args); // words come from clients in serve mode
         if(wordnet_stdout.empty())
             continue;
         std::string word_base_form;
@@ -113,7 +119,58 @@ bool get_pos_values_from_lexer(
     return true;
 }
 
+bool PosCache::lookup(const std::string &word, std::vector<std::string>* pos_values)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto p = m_map.find(word);
+    if(p == m_map.end())
+    {
+        m_misses++;
+        return false;
+    }
+    pos_values->insert(pos_values->end(), (*p).second.begin(), (*p).second.end());
+    m_hits++;
+    return true;
+}
+
+void PosCache::insert(const std::string &word, const std::vector<std::string> &pos_values)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_map.size() >= m_max_size)
+        m_map.clear(); // bound memory on unbounded input
+    m_map[word] = pos_values;
+}
+
+void PosCache::stats(size_t* size, size_t* hits, size_t* misses)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(size)
+        *size = m_map.size();
+    if(hits)
+        *hits = m_hits;
+    if(misses)
+        *misses = m_misses;
+}
+
 bool get_pos_values(
+        std::string               word,
+        std::vector<std::string>* pos_values,
+        PosCache*                 pos_cache)
+{
+    if(word.empty() || !pos_values)
+        return false;
+    // WordNet lookups fork a process per POS; batch input repeats words a lot
+    if(pos_cache && pos_cache->lookup(word, pos_values))
+        return true;
+    std::vector<std::string> uncached_pos_values;
+    bool result = get_pos_values_uncached(word, &uncached_pos_values); // slow, so done unlocked
+    pos_values->insert(pos_values->end(), uncached_pos_values.begin(), uncached_pos_values.end());
+    if(pos_cache)
+        pos_cache->insert(word, uncached_pos_values);
+    return result;
+}
+
+bool get_pos_values_uncached(
         std::string               word,
         std::vector<std::string>* pos_values)
 {
@@ -127,6 +184,7 @@ bool get_pos_values(
     std::set<std::string> unique_pos_values;
     // lookup POS in WordNet and use familiarity score for POS ranking
     {
+        xl::trace::Span span("wordnet", "lookup");
         std::vector<std::string> pos_values_from_wordnet;
         if(get_pos_values_from_wordnet(word, &pos_values_from_wordnet))
         {
@@ -152,6 +210,7 @@ bool get_pos_values(
     }
     // lookup POS in lexer hard coded categorizations in case WordNet missed it
     {
+        xl::trace::Span span("lexer", "lookup");
         std::vector<std::string> pos_values_from_lexer;
         bool found_match = false;
         found_match |= get_pos_values_from_lexer(word, &pos_values_from_lexer);
@@ -210,12 +269,15 @@ void build_pos_paths_from_pos_options(
         std::list<std::vector<int>>*                 pos_paths,                  // OUT
         const std::vector<std::vector<std::string>>* sentence_pos_options_table, // IN
         std::stack<int>*                             pos_path,                   // TEMP
-        int                                          word_index)                 // TEMP
+        int                                          word_index,                 // TEMP
+        ParseBudget*                                 budget)                     // IN
 {
     if(!pos_paths || !pos_path)
         return;
     if(static_cast<size_t>(word_index) >= sentence_pos_options_table->size())
     {
+        if(budget && !budget->check_paths(pos_paths->size()))
+            return;
         size_t n = pos_path->size();
         std::vector<int> pos_path_vec(n);
         for(int i = 0; i < static_cast<int>(n); i++)
@@ -237,15 +299,19 @@ void build_pos_paths_from_pos_options(
                 pos_paths,
                 sentence_pos_options_table,
                 pos_path,
-                word_index+1);
+                word_index+1,
+                budget);
         pos_path->pop();
+        if(budget && budget->status() != ParseBudget::STATUS_OK)
+            return; // sentences with many ambiguous words have exponentially many paths
         pos_index++;
     }
 }
 
 void build_pos_paths_from_pos_options(
         std::list<std::vector<int>>*                 pos_paths,                  // OUT
-        const std::vector<std::vector<std::string>>* sentence_pos_options_table) // IN
+        const std::vector<std::vector<std::string>>* sentence_pos_options_table, // IN
+        ParseBudget*                                 budget)                     // IN
 {
     if(!pos_paths)
         return;
@@ -255,38 +321,121 @@ void build_pos_paths_from_pos_options(
             pos_paths,
             sentence_pos_options_table,
             &pos_path,
-            word_index);
+            word_index,
+            budget);
 }
 
-void build_pos_value_paths_from_sentence(
-        std::list<std::vector<std::string>>* pos_value_paths, // OUT
-        std::string                          sentence)        // IN
+double estimate_pos_path_count(
+        const std::vector<std::vector<std::string>> &sentence_pos_options_table, // IN
+        std::vector<size_t>*                         word_indices)               // OUT
 {
-    if(!pos_value_paths)
+    double path_count = 1;
+    for(auto p = sentence_pos_options_table.begin(); p != sentence_pos_options_table.end(); p++)
+        path_count *= (*p).size();
+    if(word_indices)
+    {
+        word_indices->clear();
+        for(size_t i = 0; i<sentence_pos_options_table.size(); i++)
+            word_indices->push_back(i);
+        std::stable_sort(word_indices->begin(), word_indices->end(),
+                [&sentence_pos_options_table](size_t a, size_t b) {
+                    return sentence_pos_options_table[a].size() > sentence_pos_options_table[b].size();
+                });
+    }
+    return path_count;
+}
+
+// WordNet only knows open-class words, and get_pos_values_uncached lists
+// what it found most familiar first, ahead of what the lexer guessed from
+// suffixes. Any other option is a closed-class word from the lexer's lists,
+// such as a modal or a preposition, which the parse hinges on
+static bool is_open_class_pos_value(const std::string &pos_value)
+{
+    static const std::set<std::string> open_class_pos_values = {
+            "N", "V", "PastPart", "Adj", "Adv_V", "Adv_Gerund", "Adv_Adj", "Adv_Prep", "Adv_Modal"
+            };
+    return open_class_pos_values.find(pos_value) != open_class_pos_values.end();
+}
+
+// the least familiar open-class option of a row, or failing that the last
+// closed-class one, whose expansions are in no particular order
+static size_t lowest_ranked_pos_option(const std::vector<std::string> &pos_options)
+{
+    for(size_t i = pos_options.size(); i-- > 0;)
+    {
+        if(is_open_class_pos_value(pos_options[i]))
+            return i;
+    }
+    return pos_options.size()-1;
+}
+
+size_t trim_pos_options_table(
+        std::vector<std::vector<std::string>>* sentence_pos_options_table, // IN/OUT
+        double                                 max_path_count)             // IN
+{
+    if(!sentence_pos_options_table)
+        return 0;
+    size_t trimmed_count = 0;
+    double path_count = estimate_pos_path_count(*sentence_pos_options_table);
+    while(path_count > max_path_count)
+    {
+        std::vector<std::string>* widest_row = NULL;
+        for(auto p = sentence_pos_options_table->begin(); p != sentence_pos_options_table->end(); p++)
+        {
+            if(!widest_row || (*p).size() > widest_row->size())
+                widest_row = &*p;
+        }
+        if(!widest_row || widest_row->size() <= 1)
+            break;
+        path_count = path_count/widest_row->size()*(widest_row->size()-1);
+        widest_row->erase(widest_row->begin()+lowest_ranked_pos_option(*widest_row)); // keeps the rest in order
+        trimmed_count++;
+    }
+    return trimmed_count;
+}
+
+void build_pos_options_table_from_tokens(
+        std::vector<std::vector<std::string>>* sentence_pos_options_table, // IN/OUT
+        const std::string                     &sentence,                   // IN
+        const std::vector<token_view_t>       &tokens,                     // IN
+        PosCache*                              pos_cache)                  // IN
+{
+    if(!sentence_pos_options_table)
         return;
-    std::vector<std::vector<std::string>> sentence_pos_options_table;
-    std::vector<std::string> words = xl::tokenize(sentence);
-    sentence_pos_options_table.resize(words.size());
+    sentence_pos_options_table->resize(tokens.size());
     int word_index = 0;
-    for(auto t = words.begin(); t != words.end(); t++)
+    for(auto t = tokens.begin(); t != tokens.end(); t++)
     {
-        std::cerr << "INFO: " << *t << "<";
-        std::vector<std::string> pos_values;
-        get_pos_values(*t, &pos_values);
+        xl::trace::Span span("pos_lookup", "lookup");
+        span.arg("word_index", word_index);
+        std::string word = sentence.substr((*t).m_offset, (*t).m_length);
+        std::vector<std::string> &pos_values = (*sentence_pos_options_table)[word_index];
+        if(pos_values.empty())
+            get_pos_values(word, &pos_values, pos_cache);
+        std::stringstream ss;
+        ss << "INFO: " << word << "<";
         for(auto r = pos_values.begin(); r != pos_values.end(); r++)
-        {
-            sentence_pos_options_table[word_index].push_back(*r);
-            std::cerr << *r << " ";
-        }
-        std::cerr << ">" << std::endl;
+            ss << *r << " ";
+        ss << ">" << std::endl;
+        std::cerr << ss.str(); // in one piece, since parses may run on several threads
         word_index++;
     }
+}
+
+void build_pos_value_paths_from_pos_options_table(
+        std::list<std::vector<std::string>>*         pos_value_paths,            // OUT
+        const std::vector<std::vector<std::string>> &sentence_pos_options_table, // IN
+        ParseBudget*                                 budget)                     // IN
+{
+    if(!pos_value_paths)
+        return;
     std::list<std::vector<int>> pos_paths;
-    build_pos_paths_from_pos_options(&pos_paths, &sentence_pos_options_table);
+    build_pos_paths_from_pos_options(&pos_paths, &sentence_pos_options_table, budget);
     int path_index = 0;
     for(auto p = pos_paths.begin(); p != pos_paths.end(); p++)
     {
-        std::cerr << "INFO: path #" << path_index << ": ";
+        std::stringstream ss;
+        ss << "INFO: path #" << path_index << ": ";
         std::vector<std::string> pos_value_path;
         int word_index = 0;
         auto pos_indices = *p;
@@ -294,15 +443,42 @@ void build_pos_value_paths_from_sentence(
         {
             std::string pos_value = sentence_pos_options_table[word_index][*q];
             pos_value_path.push_back(pos_value);
-            std::cerr << pos_value << " ";
+            ss << pos_value << " ";
             word_index++;
         }
-        std::cerr << std::endl;
+        ss << std::endl;
+        std::cerr << ss.str();
         pos_value_paths->push_back(pos_value_path);
         path_index++;
     }
 }
 
+void build_pos_value_paths_from_tokens(
+        std::list<std::vector<std::string>>* pos_value_paths, // OUT
+        const std::string                   &sentence,        // IN
+        const std::vector<token_view_t>     &tokens,          // IN
+        PosCache*                            pos_cache,       // IN
+        ParseBudget*                         budget)          // IN
+{
+    if(!pos_value_paths)
+        return;
+    std::vector<std::vector<std::string>> sentence_pos_options_table;
+    build_pos_options_table_from_tokens(&sentence_pos_options_table, sentence, tokens, pos_cache);
+    build_pos_value_paths_from_pos_options_table(pos_value_paths, sentence_pos_options_table, budget);
+}
+
+void build_pos_value_paths_from_sentence(
+        std::list<std::vector<std::string>>* pos_value_paths, // OUT
+        std::string                          sentence,        // IN
+        PosCache*                            pos_cache,       // IN
+        ParseBudget*                         budget)          // IN
+{
+    std::string normalized_sentence;
+    std::vector<token_view_t> tokens;
+    normalize_sentence(sentence, &normalized_sentence, &tokens, false);
+    build_pos_value_paths_from_tokens(pos_value_paths, normalized_sentence, tokens, pos_cache, budget);
+}
+
 void test_build_pos_value_paths()
 {
     std::list<std::vector<std::string>> pos_value_paths;
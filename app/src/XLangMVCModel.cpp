@@ -25,17 +25,11 @@
 #include <string.h> // memset
 #include <string> // std::string
 #include <vector> // std::vector
+#include <fstream> // std::ifstream
+#include <stdlib.h> // atol
 
-#ifdef INCLUDE_PATH_EXTERN
-    #define TIXML_USE_TICPP
-#endif
-#ifdef TIXML_USE_TICPP
-    #include "ticpp/ticpp.h"
-    #include <map> // std::map
-
-    // prototype
-    extern uint32_t name_to_id(std::string name);
-#endif
+// prototype
+extern uint32_t name_to_id(std::string name);
 
 namespace xl { namespace mvc {
 
@@ -44,7 +38,7 @@ node::SymbolNode* MVCModel::make_symbol(TreeContext* tc, uint32_t lexer_id, YYLT
     va_list ap;
     va_start(ap, size);
     node::SymbolNode* node = new (PNEW(tc->alloc(), node::, NodeIdentIFace))
-            node::SymbolNode(lexer_id, loc, size, ap);
+            node::SymbolNode(tc, lexer_id, loc, size, ap);
     va_end(ap);
     return node;
 }
@@ -52,7 +46,7 @@ node::SymbolNode* MVCModel::make_symbol(TreeContext* tc, uint32_t lexer_id, YYLT
 node::SymbolNode* MVCModel::make_symbol(TreeContext* tc, uint32_t lexer_id, YYLTYPE loc, std::vector<node::NodeIdentIFace*>& vec)
 {
     return new (PNEW(tc->alloc(), node::, NodeIdentIFace))
-            node::SymbolNode(lexer_id, loc, vec);
+            node::SymbolNode(tc, lexer_id, loc, vec);
 }
 
 template<>
@@ -75,7 +69,6 @@ node::NodeIdentIFace* MVCModel::make_term<
             node::TermNode<node::NodeIdentIFace::IDENT>(lexer_id, loc, value); // supports non-trivial dtor
 }
 
-#ifdef TIXML_USE_TICPP
 static node::NodeIdentIFace* _make_term_from_typename(
         TreeContext* tc, std::string _typename, uint32_t lexer_id, std::string value)
 {
@@ -84,7 +77,7 @@ static node::NodeIdentIFace* _make_term_from_typename(
     if(_typename == "int")
         return mvc::MVCModel::make_term(tc, lexer_id, dummy_loc,
                 static_cast<node::TermInternalType<node::NodeIdentIFace::INT>::type>(
-                        atoi(value.c_str())
+                        atol(value.c_str())
                         ));
     if(_typename == "float")
         return mvc::MVCModel::make_term(tc, lexer_id, dummy_loc,
@@ -109,83 +102,126 @@ static node::NodeIdentIFace* _make_term_from_typename(
     return NULL;
 }
 
-static node::NodeIdentIFace* _make_ast_from_ticpp(TreeContext* tc, ticpp::Node* ticpp_node)
+
+static node::NodeIdentIFace* _make_ast_from_binary(
+        TreeContext* tc, const binary::TreeView &view, uint32_t index)
 {
     static YYLTYPE dummy_loc;
     memset(&dummy_loc, 0, sizeof(dummy_loc));
-    if(dynamic_cast<ticpp::Document*>(ticpp_node))
+    const binary::node_record_t &record = view.node(index);
+    switch(record.type)
     {
-        uint32_t lexer_id = 0;
-        node::SymbolNode* document_node = mvc::MVCModel::make_symbol(tc, lexer_id, dummy_loc, 0);
-        if(ticpp_node->NoChildren())
-            return document_node;
-        ticpp::Iterator<ticpp::Node> p;
-        for(p = p.begin(ticpp_node); p != p.end(); p++)
-            document_node->push_back(_make_ast_from_ticpp(tc, p.Get()));
-        if(document_node->size() == 1)
-        {
-            node::NodeIdentIFace* root_node = (*document_node)[0];
-            root_node->detach();
-            tc->alloc()._free(document_node);
-            return root_node;
-        }
-        return document_node;
+        case node::NodeIdentIFace::INT:
+            return mvc::MVCModel::make_term(tc, record.lexer_id, dummy_loc,
+                    static_cast<node::TermInternalType<node::NodeIdentIFace::INT>::type>(record.int_value));
+        case node::NodeIdentIFace::FLOAT:
+            return mvc::MVCModel::make_term(tc, record.lexer_id, dummy_loc,
+                    static_cast<node::TermInternalType<node::NodeIdentIFace::FLOAT>::type>(record.float_value));
+        case node::NodeIdentIFace::STRING:
+            return mvc::MVCModel::make_term(tc, record.lexer_id, dummy_loc,
+                    static_cast<node::TermInternalType<node::NodeIdentIFace::STRING>::type>(
+                            tc->alloc_string(view.string_at(record.string_offset))
+                            ));
+        case node::NodeIdentIFace::CHAR:
+            return mvc::MVCModel::make_term(tc, record.lexer_id, dummy_loc,
+                    static_cast<node::TermInternalType<node::NodeIdentIFace::CHAR>::type>(record.char_value));
+        case node::NodeIdentIFace::IDENT:
+            return mvc::MVCModel::make_term(tc, record.lexer_id, dummy_loc,
+                    static_cast<node::TermInternalType<node::NodeIdentIFace::IDENT>::type>(
+                            tc->alloc_unique_string(view.string_at(record.string_offset))
+                            ));
+        case node::NodeIdentIFace::SYMBOL:
+            {
+                node::SymbolNode* symbol_node = mvc::MVCModel::make_symbol(tc, record.lexer_id, dummy_loc, 0);
+                uint32_t child_index = index+1;
+                for(uint32_t i = 0; i<record.child_count; i++)
+                {
+                    symbol_node->push_back(_make_ast_from_binary(tc, view, child_index));
+                    child_index = view.next_sibling(child_index);
+                }
+                return symbol_node;
+            }
+        default:
+            break;
     }
-    if(dynamic_cast<ticpp::Declaration*>(ticpp_node))
+    return NULL; // binary::NODE_NULL
+}
+
+node::NodeIdentIFace* MVCModel::make_ast(TreeContext* tc, const binary::TreeView &view)
+{
+    if(!view.is_valid())
         return NULL;
-    if(dynamic_cast<ticpp::Element*>(ticpp_node))
+    return _make_ast_from_binary(tc, view, 0);
+}
+
+// builds the next top-level tree from the reader; open symbols are kept on an
+// explicit stack, so memory use follows tree depth, not document size
+node::NodeIdentIFace* MVCModel::make_ast(TreeContext* tc, XMLReader &reader)
+{
+    static YYLTYPE dummy_loc;
+    memset(&dummy_loc, 0, sizeof(dummy_loc));
+    std::vector<node::SymbolNode*> symbol_stack;
+    for(;;)
     {
-        std::string block_name;
-        ticpp_node->GetValue(&block_name);
-        if(block_name == "NULL")
-            return NULL;
-        std::string node_typename;
-        uint32_t lexer_id = 0;
-        std::string node_value;
-        ticpp::Element* elem = dynamic_cast<ticpp::Element*>(ticpp_node);
-        if(elem)
+        switch(reader.next())
         {
-            std::map<std::string, std::string> attr_map; // in case you need it
-            ticpp::Iterator<ticpp::Attribute> q;
-            for(q = q.begin(elem); q != q.end(); q++)
-            {
-                std::string attr_name, attr_value;
-                q->GetName(&attr_name);
-                q->GetValue(&attr_value);
-                attr_map[attr_name] = attr_value;
-            }
-            if(attr_map.size())
-            {
-                node_typename = attr_map["type"];
-                node_value = attr_map["value"];
-                lexer_id = name_to_id(node_typename);
-            }
-        }
-        node::NodeIdentIFace* term_node = _make_term_from_typename(tc, node_typename, lexer_id, node_value);
-        if(term_node)
-            return term_node;
-        else
-        {
-            node::SymbolNode* symbol_node = mvc::MVCModel::make_symbol(tc, lexer_id, dummy_loc, 0);
-            ticpp::Iterator<ticpp::Node> r;
-            for(r = r.begin(ticpp_node); r != r.end(); r++)
-                symbol_node->push_back(_make_ast_from_ticpp(tc, r.Get()));
-            return symbol_node;
+            case XMLReader::ELEMENT_BEGIN:
+                {
+                    const std::string* node_typename = reader.attr("type");
+                    if(reader.name() == "NULL")
+                    {
+                        if(symbol_stack.size())
+                            symbol_stack.back()->push_back(NULL);
+                        break;
+                    }
+                    if(!node_typename)
+                        return NULL;
+                    uint32_t lexer_id = name_to_id(*node_typename);
+                    if(reader.name() == "symbol")
+                    {
+                        node::SymbolNode* symbol_node = mvc::MVCModel::make_symbol(tc, lexer_id, dummy_loc, 0);
+                        if(symbol_stack.size())
+                            symbol_stack.back()->push_back(symbol_node);
+                        symbol_stack.push_back(symbol_node);
+                        break;
+                    }
+                    const std::string* node_value = reader.attr("value");
+                    if(reader.name() != "term" || !node_value)
+                        return NULL;
+                    node::NodeIdentIFace* term_node =
+                            _make_term_from_typename(tc, *node_typename, lexer_id, *node_value);
+                    if(!term_node)
+                        return NULL;
+                    if(symbol_stack.empty())
+                    {
+                        reader.next(); // consume end of self-closing term
+                        return term_node;
+                    }
+                    symbol_stack.back()->push_back(term_node);
+                }
+                break;
+            case XMLReader::ELEMENT_END:
+                if(reader.name() != "symbol")
+                    break;
+                if(symbol_stack.empty())
+                    return NULL;
+                if(symbol_stack.size() == 1)
+                    return symbol_stack.back();
+                symbol_stack.pop_back();
+                break;
+            default: // end of input or parse error
+                return NULL;
         }
     }
-    return NULL;
 }
-#endif
 
 node::NodeIdentIFace* MVCModel::make_ast(TreeContext* tc, std::string filename)
 {
-#ifdef TIXML_USE_TICPP
-    ticpp::Document doc(filename.c_str());
-    doc.LoadFile();
-    return _make_ast_from_ticpp(tc, &doc);
-#else
-    return NULL;
-#endif
+    std::ifstream file(filename.c_str());
+    if(!file.is_open())
+        return NULL;
+    XMLReader reader(file);
+    return make_ast(tc, reader);
 }
 
 } }
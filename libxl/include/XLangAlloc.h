@@ -22,6 +22,7 @@
 #include <string> // std::string
 #include <stddef.h> // size_t
 #include <list> // std::list
+#include <iostream> // std::ostream
 
 #define DTOR_CB(ns, c) [](void* x) {      \
         reinterpret_cast<ns c*>(x)->~c(); \
@@ -51,7 +52,7 @@ public:
     size_t size() const { return m_size_bytes; }
     std::string filename() const { return m_filename; }
     size_t line_number() const { return m_line_number; }
-    void dump(std::string indent) const;
+    void dump(std::string indent, std::ostream &os = std::cout) const;
 
 private:
     size_t m_size_bytes;
@@ -71,7 +72,7 @@ public:
     void* _malloc(size_t size_bytes, std::string filename, size_t line_number, MemChunk::dtor_cb_t dtor_cb = NULL);
     void _free(void* ptr);
     void _free();
-    void dump(std::string indent) const;
+    void dump(std::string indent, std::ostream &os = std::cout) const;
 
 private:
     typedef std::map<void*, MemChunk*> internal_type_t;
@@ -0,0 +1,118 @@
+// XLang
+// -- A parser framework for language modeling
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef XLANG_BINARY_H_
+#define XLANG_BINARY_H_
+
+#include "XLangType.h" // uint32_t
+#include <iostream> // std::ostream
+#include <stddef.h> // size_t
+
+namespace xl { namespace node { class NodeIdentIFace; } }
+
+// Compact binary tree format. A stream is a sequence of self-contained blocks,
+// one per tree, each laid out as:
+//
+//   header_t | lexer_entry_t[lexer_count] | node_record_t[node_count] | string table
+//
+// Nodes are stored in preorder; a node's children follow it directly and its
+// subtree spans subtree_size records, so the next sibling of node i is at
+// i+subtree_size. Strings (lexer names and term values) are NUL-terminated
+// and referenced by byte offset into the string table. Integers are in host
+// byte order. Blocks are padded to 8 bytes so they can be read in place from
+// a memory-mapped file.
+
+namespace xl { namespace binary {
+
+enum { VERSION = 1 };
+enum { NODE_NULL = 0xFF }; // node_record_t::type of a missing child
+
+struct header_t
+{
+    char     magic[4]; // "XLB1"
+    uint32_t version;
+    uint32_t block_size; // header included, padded
+    uint32_t lexer_count;
+    uint32_t node_count;
+    uint32_t string_table_size;
+};
+
+struct lexer_entry_t
+{
+    uint32_t lexer_id;
+    uint32_t name_offset;
+};
+
+struct node_record_t
+{
+    uint8_t  type; // node::NodeIdentIFace::type_t or NODE_NULL
+    uint8_t  reserved[3];
+    uint32_t lexer_id;
+    uint32_t child_count;
+    uint32_t subtree_size; // self included
+    union
+    {
+        int64_t   int_value;
+        float32_t float_value;
+        char      char_value;
+        uint32_t  string_offset; // STRING and IDENT
+    };
+};
+
+bool write_tree(std::ostream &os, const node::NodeIdentIFace* _node);
+
+// read-only view of one block, used in place (no deserialization)
+class TreeView
+{
+public:
+    TreeView(const char* buf, size_t size);
+    bool is_valid() const
+    {
+        return m_header != NULL;
+    }
+    size_t block_size() const
+    {
+        return m_header->block_size;
+    }
+    uint32_t node_count() const
+    {
+        return m_header->node_count;
+    }
+    const node_record_t &node(uint32_t index) const
+    {
+        return m_nodes[index];
+    }
+    uint32_t next_sibling(uint32_t index) const
+    {
+        return index+m_nodes[index].subtree_size;
+    }
+    const char* string_at(uint32_t offset) const
+    {
+        return m_strings+offset;
+    }
+    const char* name(uint32_t index) const;
+
+private:
+    const header_t*      m_header;
+    const lexer_entry_t* m_lexers;
+    const node_record_t* m_nodes;
+    const char*          m_strings;
+};
+
+} }
+
+#endif
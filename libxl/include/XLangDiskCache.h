@@ -0,0 +1,67 @@
+// XLang
+// -- A parser framework for language modeling
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef XLANG_DISK_CACHE_H_
+#define XLANG_DISK_CACHE_H_
+
+#include "XLangType.h" // uint64_t
+#include <string> // std::string
+#include <mutex> // std::mutex
+#include <atomic> // std::atomic
+#include <stddef.h> // size_t
+
+namespace xl {
+
+// key/value store in a directory, one file per entry named by a hash of its
+// key; entries are written to a temporary file and renamed into place, so
+// any number of processes may share the directory, and once it outgrows its
+// size cap the least recently used entries are removed, along with old
+// temporary files of writers that died
+class DiskCache
+{
+public:
+    DiskCache(std::string dir, size_t max_size_bytes);
+    bool is_open() const
+    {
+        return m_open;
+    }
+    bool lookup(const std::string &key, std::string* value);
+    bool store(const std::string &key, const std::string &value);
+    size_t size_bytes() const
+    {
+        return m_size_bytes;
+    }
+    static uint64_t hash(const std::string &s);
+
+private:
+    std::string         m_dir;
+    size_t              m_max_size_bytes;
+    bool                m_open;
+    std::atomic<size_t> m_size_bytes; // as last counted, plus what this process stored since
+    std::atomic<size_t> m_temp_count;
+    std::mutex          m_evict_mutex;
+
+    std::string entry_path(const std::string &key) const;
+    void evict();
+
+    DiskCache(const DiskCache&);
+    DiskCache& operator=(const DiskCache&);
+};
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+// XLang
+// -- A parser framework for language modeling
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef XLANG_MAPPED_FILE_H_
+#define XLANG_MAPPED_FILE_H_
+
+#include <string> // std::string
+#include <stddef.h> // size_t
+
+namespace xl {
+
+// read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+    MappedFile() : m_data(NULL), m_size(0)
+    {}
+    MappedFile(std::string filename) : m_data(NULL), m_size(0)
+    {
+        open(filename);
+    }
+    ~MappedFile()
+    {
+        close();
+    }
+    bool open(std::string filename);
+    void close();
+    bool is_open() const
+    {
+        return m_data != NULL;
+    }
+    const char* data() const
+    {
+        return m_data;
+    }
+    size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    const char* m_data;
+    size_t      m_size;
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+}
+
+#endif
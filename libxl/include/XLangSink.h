@@ -0,0 +1,118 @@
+// XLang
+// -- A parser framework for language modeling
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef XLANG_SINK_H_
+#define XLANG_SINK_H_
+
+#include <streambuf> // std::streambuf
+#include <string> // std::string
+#include <vector> // std::vector
+#include <stddef.h> // size_t
+
+namespace xl {
+
+// buffered output target for printers
+// NOTE: wrap in a std::ostream; nothing is written to the target until the
+//       buffer fills up or flush() is called
+class Sink : public std::streambuf
+{
+public:
+    enum { DEFAULT_BUF_SIZE = 64*1024 };
+
+    Sink(size_t buf_size = DEFAULT_BUF_SIZE);
+    virtual ~Sink()
+    {}
+    bool flush();
+
+protected:
+    // write out [buf, buf+n) to the underlying target
+    virtual bool drain(const char* buf, size_t n) = 0;
+
+    int_type        overflow(int_type c);
+    std::streamsize xsputn(const char* s, std::streamsize n);
+    int             sync();
+
+private:
+    std::vector<char> m_buf;
+};
+
+class FdSink : public Sink
+{
+public:
+    FdSink(int fd, size_t buf_size = DEFAULT_BUF_SIZE)
+        : Sink(buf_size), m_fd(fd)
+    {}
+    ~FdSink()
+    {
+        flush();
+    }
+
+protected:
+    bool drain(const char* buf, size_t n);
+
+private:
+    int m_fd;
+};
+
+class StringSink : public Sink
+{
+public:
+    StringSink(size_t buf_size = DEFAULT_BUF_SIZE)
+        : Sink(buf_size)
+    {}
+    const std::string &str()
+    {
+        flush();
+        return m_str;
+    }
+    void clear()
+    {
+        flush();
+        m_str.clear();
+    }
+
+protected:
+    bool drain(const char* buf, size_t n);
+
+private:
+    std::string m_str;
+};
+
+class CallbackSink : public Sink
+{
+public:
+    typedef bool (*drain_cb_t)(const char* buf, size_t n, void* context);
+
+    CallbackSink(drain_cb_t drain_cb, void* context = NULL, size_t buf_size = DEFAULT_BUF_SIZE)
+        : Sink(buf_size), m_drain_cb(drain_cb), m_context(context)
+    {}
+    ~CallbackSink()
+    {
+        flush();
+    }
+
+protected:
+    bool drain(const char* buf, size_t n);
+
+private:
+    drain_cb_t m_drain_cb;
+    void*      m_context;
+};
+
+}
+
+#endif
@@ -20,6 +20,7 @@
 
 #include <signal.h> // siginfo_t
 #include <string> // std::string
+#include <vector> // std::vector
 
 namespace xl { namespace system {
 
@@ -27,10 +28,14 @@ typedef void (*sa_sigaction_t)(int, siginfo_t*, void*);
 
 std::string get_execname();
 std::string shell_capture(std::string cmd);
+// runs args[0] found on PATH without a shell, so arguments are passed through
+// verbatim and never expanded
+std::string exec_capture(const std::vector<std::string> &args);
 std::string get_basename(std::string filename);
 void backtrace_sighandler(int sig, siginfo_t* info, void* secret);
 void gdb_sighandler(int sig, siginfo_t* info, void* secret);
 void add_sighandler(int sig, sa_sigaction_t _sa_sigaction);
+double monotonic_seconds(); // for timing, not for telling the time
 
 } }
 
@@ -0,0 +1,74 @@
+// XLang
+// -- A parser framework for language modeling
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef XLANG_TRACE_H_
+#define XLANG_TRACE_H_
+
+#include <string> // std::string
+#include <stddef.h> // size_t
+
+namespace xl { namespace trace {
+
+enum
+{
+    DEFAULT_BUFFER_EVENTS = 65536, // per thread; the oldest are overwritten beyond this
+    MAX_SPAN_ARGS         = 3
+};
+
+// call before starting the threads to trace; spans are free until then
+void enable(size_t buffer_events = DEFAULT_BUFFER_EVENTS);
+bool enabled();
+// names the calling thread's track
+void set_thread_name(const char* name);
+// names and categories must be string literals, they are kept by pointer
+void record(const char* name, const char* category, double start_us, double duration_us,
+        int arg_count, const char* const* arg_names, const long* arg_values);
+// writes Chrome trace-event JSON of every thread's events, once the traced
+// threads are done
+bool write_json(std::string filename);
+
+// records the time from its construction to its destruction
+class Span
+{
+public:
+    Span(const char* name, const char* category);
+    ~Span();
+    void arg(const char* name, long value)
+    {
+        if(m_arg_count < MAX_SPAN_ARGS)
+        {
+            m_arg_names[m_arg_count]  = name;
+            m_arg_values[m_arg_count] = value;
+            m_arg_count++;
+        }
+    }
+
+private:
+    const char* m_name;
+    const char* m_category;
+    double      m_start_us; // negative when not tracing
+    int         m_arg_count;
+    const char* m_arg_names[MAX_SPAN_ARGS];
+    long        m_arg_values[MAX_SPAN_ARGS];
+
+    Span(const Span&);
+    Span& operator=(const Span&);
+};
+
+} }
+
+#endif
@@ -21,6 +21,7 @@
 #include "XLangAlloc.h" // Allocator
 #include <string> // std::string
 #include <set> // std::set
+#include <stddef.h> // size_t
 
 namespace xl { namespace node { class NodeIdentIFace; } }
 
@@ -36,6 +37,7 @@ public:
     node::NodeIdentIFace* &root() { return m_root; }
     const std::string* alloc_unique_string(std::string name);
     std::string* alloc_string(std::string s);
+    size_t unique_string_count() const { return m_string_set.size(); }
 
 private:
     Allocator &m_alloc;
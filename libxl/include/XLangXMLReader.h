@@ -0,0 +1,88 @@
+// XLang
+// -- A parser framework for language modeling
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef XLANG_XML_READER_H_
+#define XLANG_XML_READER_H_
+
+#include <iostream> // std::istream
+#include <string> // std::string
+#include <vector> // std::vector
+#include <stddef.h> // size_t
+
+namespace xl {
+
+// streaming pull reader for the element/attribute subset of xml written by
+// visitor::XMLPrinter (no DOM; text content, comments and declarations are
+// skipped)
+// NOTE: attribute values may be unquoted, as XMLPrinter writes numbers and
+//       identifiers bare; quoted values are returned without their quotes
+//       and still escaped
+class XMLReader
+{
+public:
+    typedef enum
+    {
+        END_OF_INPUT,
+        ELEMENT_BEGIN,
+        ELEMENT_END, // also reported after a self-closing element
+        PARSE_ERROR
+    } event_t;
+
+    XMLReader(std::istream &is);
+    event_t next();
+    const std::string &name() const
+    {
+        return m_name;
+    }
+    const std::string* attr(const std::string &key) const;
+    bool eof() const
+    {
+        return m_eof;
+    }
+    const std::string &error() const
+    {
+        return m_error;
+    }
+    size_t line() const
+    {
+        return m_line;
+    }
+
+private:
+    typedef std::pair<std::string, std::string> attr_t;
+
+    std::streambuf*     m_sb;
+    std::string         m_name;
+    std::vector<attr_t> m_attrs; // entries past m_attr_count are kept for reuse
+    size_t              m_attr_count;
+    bool                m_pending_end;
+    bool                m_eof;
+    std::string         m_error;
+    size_t              m_line;
+
+    int peek();
+    int get();
+    void skip_space();
+    bool skip_past(const char* terminator);
+    bool read_name(std::string* s);
+    bool read_value(std::string* s);
+    event_t fail(const char* message);
+};
+
+}
+
+#endif
@@ -22,6 +22,8 @@
 #include "node/XLangNodeIFace.h" // node::NodeIdentIFace
 #include "node/XLangNode.h" // node::TermNode
 #include "XLangTreeContext.h" // TreeContext
+#include "XLangBinary.h" // binary::TreeView
+#include "XLangXMLReader.h" // XMLReader
 #include "XLangType.h" // uint32_t
 #include <string> // std::string
 
@@ -39,6 +41,8 @@ struct MVCModel
     static node::SymbolNode* make_symbol(TreeContext* tc, uint32_t lexer_id, size_t size, ...);
     static node::SymbolNode* make_symbol(TreeContext* tc, uint32_t lexer_id, std::vector<node::NodeIdentIFace*>& vec);
     static node::NodeIdentIFace* make_ast(TreeContext* tc, std::string filename);
+    static node::NodeIdentIFace* make_ast(TreeContext* tc, XMLReader &reader);
+    static node::NodeIdentIFace* make_ast(TreeContext* tc, const binary::TreeView &view);
 };
 
 } }
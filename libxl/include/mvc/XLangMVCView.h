@@ -21,6 +21,7 @@
 #include "visitor/XLangVisitor.h" // visitor::VisitorDFS
 #include "visitor/XLangFilterable.h" // visitor::Filterable
 #include "XLangType.h" // NULL
+#include <iostream> // std::ostream
 
 namespace xl { namespace node { class NodeIdentIFace; } }
 
@@ -28,22 +29,33 @@ namespace xl { namespace mvc {
 
 struct MVCView
 {
-    static void annotate_tree(
-            const node::NodeIdentIFace*      _node,
-            visitor::Filterable::filter_cb_t filter_cb = NULL);
+    static void annotate_tree(node::NodeIdentIFace* _node);
     static void print_lisp(
             const node::NodeIdentIFace*       _node,
-            visitor::Filterable::filter_cb_t filter_cb = NULL);
+            visitor::Filterable::filter_cb_t filter_cb = NULL,
+            std::ostream                     &os       = std::cout);
     static void print_xml(
             const node::NodeIdentIFace*      _node,
-            visitor::Filterable::filter_cb_t filter_cb = NULL);
+            visitor::Filterable::filter_cb_t filter_cb = NULL,
+            std::ostream                     &os       = std::cout);
+    static void print_json(
+            const node::NodeIdentIFace*      _node,
+            visitor::Filterable::filter_cb_t filter_cb = NULL,
+            std::ostream                     &os       = std::cout);
     static void print_dot(
             const node::NodeIdentIFace* _node,
             bool                        horizontal          = false,
-            bool                        print_digraph_block = true);
-    static void print_dot_header(bool horizontal);
-    static void print_dot_footer();
-    static void print_graph(const node::NodeIdentIFace* p);
+            bool                        print_digraph_block = true,
+            std::ostream                &os                 = std::cout);
+    static void print_dot_header(bool horizontal, std::ostream &os = std::cout);
+    static void print_dot_footer(std::ostream &os = std::cout);
+    static void print_binary(
+            const node::NodeIdentIFace* _node,
+            std::ostream                &os = std::cout);
+    static void print_graph(
+            const node::NodeIdentIFace* p,
+            std::ostream                &os           = std::cout,
+            int                         graph_number  = 0);
 };
 
 } }
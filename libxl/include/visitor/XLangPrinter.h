@@ -20,13 +20,14 @@
 
 #include "node/XLangNodeIFace.h" // node::NodeIdentIFace
 #include "visitor/XLangVisitor.h" // visitor::VisitorDFS
+#include <iostream> // std::ostream
 
 namespace xl { namespace visitor {
 
-class TreeAnnotator : public VisitorDFS
+class LispPrinter : public VisitorDFS
 {
 public:
-    TreeAnnotator() : m_depth(0)
+    LispPrinter(std::ostream &os = std::cout) : VisitorDFS(os), m_depth(0)
     {}
     void visit(const node::SymbolNodeIFace*                             _node);
     void visit(const node::TermNodeIFace<node::NodeIdentIFace::INT>*    _node);
@@ -37,38 +38,17 @@ public:
     void visit_null();
     bool is_printer() const
     {
-        return false;
+        return true;
     }
 
 private:
     size_t m_depth;
 };
 
-class TreeAnnotatorBFS : public VisitorBFS
-{
-public:
-    TreeAnnotatorBFS() : m_bfs_index(0)
-    {}
-    void visit(const node::SymbolNodeIFace*                             _node);
-    void visit(const node::TermNodeIFace<node::NodeIdentIFace::INT>*    _node);
-    void visit(const node::TermNodeIFace<node::NodeIdentIFace::FLOAT>*  _node);
-    void visit(const node::TermNodeIFace<node::NodeIdentIFace::STRING>* _node);
-    void visit(const node::TermNodeIFace<node::NodeIdentIFace::CHAR>*   _node);
-    void visit(const node::TermNodeIFace<node::NodeIdentIFace::IDENT>*  _node);
-    void visit_null();
-    bool is_printer() const
-    {
-        return false;
-    }
-
-private:
-    size_t m_bfs_index;
-};
-
-class LispPrinter : public VisitorDFS
+struct XMLPrinter : public VisitorDFS
 {
 public:
-    LispPrinter() : m_depth(0)
+    XMLPrinter(std::ostream &os = std::cout) : VisitorDFS(os), m_depth(0)
     {}
     void visit(const node::SymbolNodeIFace*                             _node);
     void visit(const node::TermNodeIFace<node::NodeIdentIFace::INT>*    _node);
@@ -86,10 +66,11 @@ private:
     size_t m_depth;
 };
 
-struct XMLPrinter : public VisitorDFS
+// one json object per node, on a single line (no trailing newline)
+struct JsonPrinter : public VisitorDFS
 {
 public:
-    XMLPrinter() : m_depth(0)
+    JsonPrinter(std::ostream &os = std::cout) : VisitorDFS(os), m_need_comma(false)
     {}
     void visit(const node::SymbolNodeIFace*                             _node);
     void visit(const node::TermNodeIFace<node::NodeIdentIFace::INT>*    _node);
@@ -98,20 +79,23 @@ public:
     void visit(const node::TermNodeIFace<node::NodeIdentIFace::CHAR>*   _node);
     void visit(const node::TermNodeIFace<node::NodeIdentIFace::IDENT>*  _node);
     void visit_null();
+    static void print_string(std::ostream &os, const std::string &s);
     bool is_printer() const
     {
         return true;
     }
 
 private:
-    size_t m_depth;
+    bool m_need_comma;
+
+    void print_term_prefix(const node::NodeIdentIFace* _node);
 };
 
 struct DotPrinter : public VisitorDFS
 {
 public:
-    DotPrinter(bool horizontal = false, bool print_digraph_block = true)
-        : m_horizontal(horizontal), m_print_digraph_block(print_digraph_block)
+    DotPrinter(std::ostream &os = std::cout, bool horizontal = false, bool print_digraph_block = true)
+        : VisitorDFS(os), m_horizontal(horizontal), m_print_digraph_block(print_digraph_block)
     {}
     void visit(const node::SymbolNodeIFace*                             _node);
     void visit(const node::TermNodeIFace<node::NodeIdentIFace::INT>*    _node);
@@ -120,8 +104,8 @@ public:
     void visit(const node::TermNodeIFace<node::NodeIdentIFace::CHAR>*   _node);
     void visit(const node::TermNodeIFace<node::NodeIdentIFace::IDENT>*  _node);
     void visit_null();
-    static void print_header(bool horizontal);
-    static void print_footer();
+    static void print_header(std::ostream &os, bool horizontal);
+    static void print_footer(std::ostream &os);
     bool is_printer() const
     {
         return true;
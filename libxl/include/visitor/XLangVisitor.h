@@ -22,13 +22,14 @@
 #include "visitor/XLangVisitorIFace.h" // visitor::VisitorIFace
 #include <stack> // std::stack
 #include <queue> // std::queue
+#include <iostream> // std::ostream
 
 namespace xl { namespace visitor {
 
 class Visitor : virtual public VisitorIFace<const node::NodeIdentIFace>
 {
 public:
-    Visitor() : m_allow_visit_null(true)
+    Visitor(std::ostream &os = std::cout) : m_os(os), m_allow_visit_null(true)
     {}
     virtual ~Visitor()
     {}
@@ -50,6 +51,9 @@ public:
     }
     virtual bool is_printer() const = 0;
 
+protected:
+    std::ostream &m_os;
+
 private:
     bool m_allow_visit_null;
 };
@@ -118,6 +122,8 @@ protected:
 class VisitorDFS : public Visitor, public StackedVisitor<std::pair<const node::SymbolNodeIFace*, int>>
 {
 public:
+    VisitorDFS(std::ostream &os = std::cout) : Visitor(os)
+    {}
     using Visitor::visit;
     void visit(const node::SymbolNodeIFace* _node);
 
@@ -131,6 +137,8 @@ private:
 class VisitorBFS : public Visitor, public StackedVisitor<std::queue<const node::NodeIdentIFace*>>
 {
 public:
+    VisitorBFS(std::ostream &os = std::cout) : Visitor(os)
+    {}
     using Visitor::visit;
 
 private:
@@ -17,7 +17,7 @@
 
 #include "XLangAlloc.h" // Allocator
 #include <string> // std::string
-#include <iostream> // std::cout
+#include <iostream> // std::ostream
 #include <stdlib.h> // malloc
 #include <stddef.h> // size_t
 
@@ -39,9 +39,9 @@ MemChunk::~MemChunk()
     }
 }
 
-void MemChunk::dump(std::string indent) const
+void MemChunk::dump(std::string indent, std::ostream &os) const
 {
-    std::cout << indent << m_filename << ":" << m_line_number << " .. " << m_size_bytes << " bytes";
+    os << indent << m_filename << ":" << m_line_number << " .. " << m_size_bytes << " bytes";
 }
 
 Allocator::Allocator(std::string name)
@@ -79,17 +79,18 @@ void Allocator::_free()
     for(auto p = m_chunk_map.begin(); p != m_chunk_map.end(); ++p)
         delete (*p).second;
     m_chunk_map.clear();
+    m_size_bytes = 0;
 }
 
-void Allocator::dump(std::string indent) const
+void Allocator::dump(std::string indent, std::ostream &os) const
 {
-    std::cout << '\"' << m_name << "\" {" << std::endl;
+    os << '\"' << m_name << "\" {" << std::endl;
     for(auto p = m_chunk_map.begin(); p != m_chunk_map.end(); ++p)
     {
-        (*p).second->dump(indent);
-        std::cout << std::endl;
+        (*p).second->dump(indent, os);
+        os << std::endl;
     }
-    std::cout << "};" << std::endl;
+    os << "};" << std::endl;
 }
 
 }
@@ -0,0 +1,339 @@
+// XLang
+// -- A parser framework for language modeling
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "XLangAlloc.h" // Allocator
+#include "XLangTreeContext.h" // TreeContext
+#include "XLangString.h" // xl::tokenize
+#include "XLangSystem.h" // xl::system::monotonic_seconds
+#include "XLangType.h" // uint32_t
+#include "mvc/XLangMVCModel.h" // mvc::MVCModel
+#include "node/XLangNodeIFace.h" // node::NodeIdentIFace
+#include "visitor/XLangVisitor.h" // visitor::VisitorDFS
+#include <vector> // std::vector
+#include <string> // std::string
+#include <sstream> // std::stringstream
+#include <iostream> // std::cout
+#include <iomanip> // std::setprecision
+#include <stdlib.h> // atoi
+#include <stddef.h> // size_t
+
+#define BENCH_MIN_SECONDS 0.25 // per benchmark, after calibration
+#define TREE_FANOUT       10
+#define TREE_DEPTH        4    // 11111 nodes
+#define TREE_LEXER_ID     1000 // plus depth, so lists aren't flattened
+#define BULK_CHUNK_COUNT  100
+
+// every allocation goes through malloc, operator new included, so the glibc
+// entry points are wrapped to count them
+static size_t allocation_count = 0;
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size)
+{
+    allocation_count++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size)
+{
+    allocation_count++;
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    allocation_count++;
+    return __libc_realloc(ptr, size);
+}
+
+}
+
+// libxl leaves naming lexer ids to the application
+std::string id_to_name(uint32_t lexer_id)
+{
+    std::stringstream ss;
+    ss << "id" << lexer_id;
+    return ss.str();
+}
+uint32_t name_to_id(std::string name)
+{
+    return atoi(name.c_str()+2);
+}
+
+struct bench_input_t
+{
+    std::string              sentence;
+    std::string              xml_sentence; // has characters to escape
+    std::vector<std::string> words;
+    xl::Allocator            alloc;
+    xl::TreeContext          tc;
+    xl::node::NodeIdentIFace* tree;
+    size_t                   sink; // keeps results alive
+
+    bench_input_t()
+        : sentence("the quick brown fox didn't jump over the lazy dog because it wasn't in the mood today"),
+          xml_sentence("<s id=\"1\">the fox & the dog weren't \"friends\" on o'neil's farm</s>"),
+          alloc(__FILE__), tc(alloc), tree(NULL), sink(0)
+    {
+        words = xl::tokenize(sentence);
+    }
+};
+
+static xl::node::NodeIdentIFace* make_tree(xl::TreeContext &tc, int depth, size_t* leaf_index)
+{
+    if(depth == TREE_DEPTH)
+    {
+        std::stringstream ss;
+        ss << 'w' << ((*leaf_index)++ % 100);
+        return xl::mvc::MVCModel::make_term(&tc, TREE_LEXER_ID, tc.alloc_unique_string(ss.str()));
+    }
+    std::vector<xl::node::NodeIdentIFace*> children;
+    for(int i = 0; i<TREE_FANOUT; i++)
+        children.push_back(make_tree(tc, depth+1, leaf_index));
+    return xl::mvc::MVCModel::make_symbol(&tc, TREE_LEXER_ID+depth+1, children);
+}
+
+class CountingVisitorDFS : public xl::visitor::VisitorDFS
+{
+public:
+    CountingVisitorDFS()
+        : m_count(0)
+    {}
+    using xl::visitor::VisitorDFS::visit;
+    void visit(const xl::node::SymbolNodeIFace* _node)
+    {
+        m_count++;
+        xl::visitor::VisitorDFS::visit(_node);
+    }
+    void visit(const xl::node::TermNodeIFace<xl::node::NodeIdentIFace::IDENT>*)
+    {
+        m_count++;
+    }
+    bool is_printer() const
+    {
+        return false;
+    }
+    size_t count() const
+    {
+        return m_count;
+    }
+
+private:
+    size_t m_count;
+};
+
+class CountingVisitorBFS : public xl::visitor::VisitorBFS
+{
+public:
+    CountingVisitorBFS()
+        : m_count(0)
+    {}
+    using xl::visitor::VisitorBFS::visit;
+    void visit(const xl::node::SymbolNodeIFace* _node)
+    {
+        const xl::node::NodeIdentIFace* child = NULL;
+        if(next_child(_node, &child))
+        {
+            do
+            {
+                m_count++;
+            } while(next_child(NULL, &child));
+        }
+    }
+    bool is_printer() const
+    {
+        return false;
+    }
+    size_t count() const
+    {
+        return m_count;
+    }
+
+private:
+    size_t m_count;
+};
+
+// each benchmark runs its operation n times
+static void bench_allocator_malloc_free(bench_input_t* input, size_t n)
+{
+    for(size_t i = 0; i<n; i++)
+        input->alloc._free(input->alloc._malloc(64, __FILE__, __LINE__));
+}
+
+static void bench_allocator_bulk_free(bench_input_t*, size_t n)
+{
+    xl::Allocator alloc(__FILE__);
+    for(size_t i = 0; i<n; i++)
+    {
+        alloc._malloc(64, __FILE__, __LINE__);
+        if(i%BULK_CHUNK_COUNT == BULK_CHUNK_COUNT-1)
+            alloc._free();
+    }
+}
+
+// a fresh context per sentence, so most words are new
+static void bench_intern_new(bench_input_t* input, size_t n)
+{
+    xl::Allocator alloc(__FILE__);
+    xl::TreeContext* tc = NULL;
+    for(size_t i = 0; i<n; i++)
+    {
+        size_t word_index = i%input->words.size();
+        if(!word_index)
+        {
+            delete tc;
+            alloc._free();
+            tc = new xl::TreeContext(alloc);
+        }
+        input->sink += tc->alloc_unique_string(input->words[word_index])->size();
+    }
+    delete tc;
+}
+
+static void bench_intern_existing(bench_input_t* input, size_t n)
+{
+    for(size_t i = 0; i<n; i++)
+        input->sink += input->tc.alloc_unique_string(input->words[i%input->words.size()])->size();
+}
+
+static void bench_tokenize(bench_input_t* input, size_t n)
+{
+    for(size_t i = 0; i<n; i++)
+        input->sink += xl::tokenize(input->sentence).size();
+}
+
+static void bench_replace(bench_input_t* input, size_t n)
+{
+    for(size_t i = 0; i<n; i++)
+        input->sink += xl::replace(input->sentence, "n't", " not").size();
+}
+
+static void bench_regexp(bench_input_t* input, size_t n)
+{
+    std::string whole, first, second;
+    for(size_t i = 0; i<n; i++)
+    {
+        xl::regexp(input->sentence, "([a-z]+)n't ([a-z]+)", 3, &whole, &first, &second);
+        input->sink += first.size();
+    }
+}
+
+static void bench_escape_xml(bench_input_t* input, size_t n)
+{
+    for(size_t i = 0; i<n; i++)
+        input->sink += xl::escape_xml(input->xml_sentence).size();
+}
+
+static void bench_visitor_dfs(bench_input_t* input, size_t n)
+{
+    for(size_t i = 0; i<n; i++)
+    {
+        CountingVisitorDFS visitor;
+        visitor.dispatch_visit(input->tree);
+        input->sink += visitor.count();
+    }
+}
+
+static void bench_visitor_bfs(bench_input_t* input, size_t n)
+{
+    for(size_t i = 0; i<n; i++)
+    {
+        CountingVisitorBFS visitor;
+        visitor.dispatch_visit(input->tree);
+        input->sink += visitor.count();
+    }
+}
+
+typedef void (*bench_cb_t)(bench_input_t* input, size_t n);
+
+struct bench_t
+{
+    const char* name;
+    bench_cb_t  bench_cb;
+};
+
+static const bench_t benches[] = {
+        { "allocator_malloc_free",    bench_allocator_malloc_free },
+        { "allocator_bulk_free",      bench_allocator_bulk_free },
+        { "tree_context_intern_new",  bench_intern_new },
+        { "tree_context_intern_existing", bench_intern_existing },
+        { "tokenize_sentence",        bench_tokenize },
+        { "replace_sentence",         bench_replace },
+        { "regexp_sentence",          bench_regexp },
+        { "escape_xml_sentence",      bench_escape_xml },
+        { "visitor_dfs_11k_nodes",    bench_visitor_dfs },
+        { "visitor_bfs_11k_nodes",    bench_visitor_bfs }
+        };
+
+// doubles the operation count until a run takes long enough to time, then
+// reports that run
+static void run_bench(const bench_t &bench, bench_input_t* input, std::ostream &os)
+{
+    size_t n = 1;
+    double seconds = 0;
+    size_t allocations = 0;
+    for(;;)
+    {
+        size_t start_count = allocation_count;
+        double start_time = xl::system::monotonic_seconds();
+        bench.bench_cb(input, n);
+        seconds = xl::system::monotonic_seconds()-start_time;
+        allocations = allocation_count-start_count;
+        if(seconds >= BENCH_MIN_SECONDS)
+            break;
+        n *= 2;
+    }
+    os << bench.name << '\t' << std::fixed << std::setprecision(1) << seconds/n*1e9 << '\t'
+       << std::setprecision(2) << static_cast<double>(allocations)/n << '\t' << n << std::endl;
+}
+
+void display_usage()
+{
+    std::cout << "XLangBench <-- micro-benchmarks for libxl primitives" << std::endl
+              << "  usage: XLangBench [NAME...] (all if none given)" << std::endl
+              << "  prints: benchmark ns_per_op allocs_per_op ops" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    for(int i = 1; i<argc; i++)
+    {
+        if(std::string(argv[i]) == "-h" || std::string(argv[i]) == "--help")
+        {
+            display_usage();
+            return EXIT_SUCCESS;
+        }
+    }
+    bench_input_t input;
+    size_t leaf_index = 0;
+    input.tree = make_tree(input.tc, 0, &leaf_index);
+    std::cout << "benchmark\tns_per_op\tallocs_per_op\tops" << std::endl;
+    for(size_t i = 0; i<sizeof(benches)/sizeof(*benches); i++)
+    {
+        bool selected = (argc == 1);
+        for(int j = 1; j<argc && !selected; j++)
+            selected = (std::string(benches[i].name).find(argv[j]) != std::string::npos);
+        if(selected)
+            run_bench(benches[i], &input, std::cout);
+    }
+    return EXIT_SUCCESS;
+}
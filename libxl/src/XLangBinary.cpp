@@ -0,0 +1,224 @@
+// XLang
+// -- A parser framework for language modeling
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "XLangBinary.h" // binary::write_tree
+#include "node/XLangNodeIFace.h" // node::NodeIdentIFace
+#include <string.h> // memcmp
+#include <string> // std::string
+#include <vector> // std::vector
+#include <map> // std::map
+
+namespace xl { namespace binary {
+
+static const char MAGIC[4] = {'X', 'L', 'B', '1'};
+
+struct tables_t
+{
+    std::vector<node_record_t>        m_nodes;
+    std::map<uint32_t, uint32_t>      m_lexer_name_offsets; // sorted by lexer id
+    std::map<std::string, uint32_t>   m_string_offsets;
+    std::string                       m_strings;
+
+    uint32_t add_string(const std::string &s)
+    {
+        auto p = m_string_offsets.find(s);
+        if(p != m_string_offsets.end())
+            return (*p).second;
+        uint32_t offset = m_strings.size();
+        m_strings.append(s.c_str(), s.size()+1);
+        m_string_offsets.insert(std::make_pair(s, offset));
+        return offset;
+    }
+};
+
+static void add_node(tables_t &tables, const node::NodeIdentIFace* _node)
+{
+    uint32_t index = tables.m_nodes.size();
+    tables.m_nodes.push_back(node_record_t());
+    node_record_t* record = &tables.m_nodes.back();
+    memset(record, 0, sizeof(node_record_t));
+    record->subtree_size = 1;
+    if(!_node)
+    {
+        record->type = NODE_NULL;
+        return;
+    }
+    record->type     = _node->type();
+    record->lexer_id = _node->lexer_id();
+    if(tables.m_lexer_name_offsets.find(_node->lexer_id()) == tables.m_lexer_name_offsets.end())
+    {
+        tables.m_lexer_name_offsets.insert(
+                std::make_pair(_node->lexer_id(), tables.add_string(_node->name())));
+    }
+    switch(_node->type())
+    {
+        case node::NodeIdentIFace::INT:
+            record->int_value =
+                    dynamic_cast<const node::TermNodeIFace<node::NodeIdentIFace::INT>*>(_node)->value();
+            break;
+        case node::NodeIdentIFace::FLOAT:
+            record->float_value =
+                    dynamic_cast<const node::TermNodeIFace<node::NodeIdentIFace::FLOAT>*>(_node)->value();
+            break;
+        case node::NodeIdentIFace::STRING:
+            record->string_offset = tables.add_string(
+                    *dynamic_cast<const node::TermNodeIFace<node::NodeIdentIFace::STRING>*>(_node)->value());
+            break;
+        case node::NodeIdentIFace::CHAR:
+            record->char_value =
+                    dynamic_cast<const node::TermNodeIFace<node::NodeIdentIFace::CHAR>*>(_node)->value();
+            break;
+        case node::NodeIdentIFace::IDENT:
+            record->string_offset = tables.add_string(
+                    *dynamic_cast<const node::TermNodeIFace<node::NodeIdentIFace::IDENT>*>(_node)->value());
+            break;
+        case node::NodeIdentIFace::SYMBOL:
+            {
+                auto symbol = dynamic_cast<const node::SymbolNodeIFace*>(_node);
+                uint32_t child_count = symbol->size();
+                for(uint32_t i = 0; i<child_count; i++)
+                    add_node(tables, (*symbol)[i]); // NOTE: invalidates record
+                tables.m_nodes[index].child_count  = child_count;
+                tables.m_nodes[index].subtree_size = tables.m_nodes.size()-index;
+            }
+            break;
+    }
+}
+
+bool write_tree(std::ostream &os, const node::NodeIdentIFace* _node)
+{
+    tables_t tables;
+    add_node(tables, _node);
+    std::vector<lexer_entry_t> lexers;
+    for(auto p = tables.m_lexer_name_offsets.begin(); p != tables.m_lexer_name_offsets.end(); p++)
+    {
+        lexer_entry_t entry;
+        entry.lexer_id    = (*p).first;
+        entry.name_offset = (*p).second;
+        lexers.push_back(entry);
+    }
+    size_t unpadded_size = sizeof(header_t)+
+            lexers.size()*sizeof(lexer_entry_t)+
+            tables.m_nodes.size()*sizeof(node_record_t)+
+            tables.m_strings.size();
+    size_t padding = (8-unpadded_size%8)%8;
+    header_t header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version           = VERSION;
+    header.block_size        = unpadded_size+padding;
+    header.lexer_count       = lexers.size();
+    header.node_count        = tables.m_nodes.size();
+    header.string_table_size = tables.m_strings.size();
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if(lexers.size())
+        os.write(reinterpret_cast<const char*>(&lexers[0]), lexers.size()*sizeof(lexer_entry_t));
+    os.write(reinterpret_cast<const char*>(&tables.m_nodes[0]), tables.m_nodes.size()*sizeof(node_record_t));
+    os.write(tables.m_strings.c_str(), tables.m_strings.size());
+    os.write("\0\0\0\0\0\0\0", padding);
+    return os.good();
+}
+
+TreeView::TreeView(const char* buf, size_t size)
+    : m_header(NULL), m_lexers(NULL), m_nodes(NULL), m_strings(NULL)
+{
+    if(!buf || size < sizeof(header_t))
+        return;
+    const header_t* header = reinterpret_cast<const header_t*>(buf);
+    if(memcmp(header->magic, MAGIC, sizeof(MAGIC)) || header->version != VERSION ||
+            header->block_size > size)
+        return;
+    uint64_t used_size = sizeof(header_t)+
+            static_cast<uint64_t>(header->lexer_count)*sizeof(lexer_entry_t)+
+            static_cast<uint64_t>(header->node_count)*sizeof(node_record_t)+
+            header->string_table_size;
+    if(used_size > header->block_size || !header->node_count)
+        return;
+    const lexer_entry_t* lexers = reinterpret_cast<const lexer_entry_t*>(header+1);
+    const node_record_t* nodes  = reinterpret_cast<const node_record_t*>(lexers+header->lexer_count);
+    const char*          strings = reinterpret_cast<const char*>(nodes+header->node_count);
+    uint32_t string_table_size = header->string_table_size;
+    if(string_table_size && strings[string_table_size-1] != '\0')
+        return;
+    for(uint32_t i = 0; i<header->lexer_count; i++)
+    {
+        if(lexers[i].name_offset >= string_table_size)
+            return;
+    }
+
+    // check record fields and that each symbol's children tile its subtree
+    for(uint32_t i = 0; i<header->node_count; i++)
+    {
+        const node_record_t &record = nodes[i];
+        if(!record.subtree_size || record.subtree_size > header->node_count-i)
+            return;
+        switch(record.type)
+        {
+            case NODE_NULL:
+            case node::NodeIdentIFace::INT:
+            case node::NodeIdentIFace::FLOAT:
+            case node::NodeIdentIFace::CHAR:
+                if(record.subtree_size != 1)
+                    return;
+                break;
+            case node::NodeIdentIFace::STRING:
+            case node::NodeIdentIFace::IDENT:
+                if(record.subtree_size != 1 || record.string_offset >= string_table_size)
+                    return;
+                break;
+            case node::NodeIdentIFace::SYMBOL:
+                {
+                    uint64_t child_index = i+1;
+                    for(uint32_t j = 0; j<record.child_count; j++)
+                    {
+                        if(child_index >= i+record.subtree_size)
+                            return;
+                        child_index += nodes[child_index].subtree_size;
+                    }
+                    if(child_index != i+record.subtree_size)
+                        return;
+                }
+                break;
+            default:
+                return;
+        }
+    }
+    if(nodes[0].subtree_size != header->node_count)
+        return;
+    m_header  = header;
+    m_lexers  = lexers;
+    m_nodes   = nodes;
+    m_strings = strings;
+}
+
+const char* TreeView::name(uint32_t index) const
+{
+    uint32_t lexer_id = m_nodes[index].lexer_id;
+    uint32_t lo = 0, hi = m_header->lexer_count;
+    while(lo < hi)
+    {
+        uint32_t mid = (lo+hi)/2;
+        if(m_lexers[mid].lexer_id < lexer_id)
+            lo = mid+1;
+        else
+            hi = mid;
+    }
+    if(lo == m_header->lexer_count || m_lexers[lo].lexer_id != lexer_id)
+        return NULL;
+    return m_strings+m_lexers[lo].name_offset;
+}
+
+} }
@@ -0,0 +1,193 @@
+// XLang
+// -- A parser framework for language modeling
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "XLangDiskCache.h" // xl::DiskCache
+#include "XLangMappedFile.h" // xl::MappedFile
+#include <vector> // std::vector
+#include <algorithm> // std::sort
+#include <sstream> // std::stringstream
+#include <string.h> // memcmp
+#include <errno.h> // errno
+#include <stdio.h> // rename
+#include <dirent.h> // opendir
+#include <fcntl.h> // open
+#include <unistd.h> // write
+#include <sys/stat.h> // mkdir
+#include <sys/time.h> // utimes
+#include <time.h> // time
+
+#define ENTRY_MAGIC       "XLC1"
+#define ENTRY_MAGIC_SIZE  4
+#define ENTRY_SUFFIX      ".entry"
+#define TEMP_PREFIX       ".tmp."
+#define TEMP_MAX_AGE      (10*60) // seconds; a writer takes far less, so older ones were left by dead writers
+#define EVICT_LOW_PERCENT 75 // evict down to this much of the cap, so eviction is rare
+
+namespace xl {
+
+// entries are laid out as: magic | uint32_t key size | key | value
+DiskCache::DiskCache(std::string dir, size_t max_size_bytes)
+    : m_dir(dir), m_max_size_bytes(max_size_bytes), m_open(false), m_size_bytes(0), m_temp_count(0)
+{
+    if(mkdir(m_dir.c_str(), 0777) == -1 && errno != EEXIST)
+        return;
+    struct stat st;
+    m_open = (stat(m_dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode));
+    if(m_open && m_max_size_bytes)
+        evict(); // counts what earlier runs left behind
+}
+
+uint64_t DiskCache::hash(const std::string &s)
+{
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for(auto p = s.begin(); p != s.end(); p++)
+    {
+        h ^= static_cast<unsigned char>(*p);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+std::string DiskCache::entry_path(const std::string &key) const
+{
+    static const char hex_digits[] = "0123456789abcdef";
+    uint64_t h = hash(key);
+    std::string name(16, '0');
+    for(int i = 15; i >= 0; i--, h >>= 4)
+        name[i] = hex_digits[h & 0xF];
+    return m_dir + "/" + name + ENTRY_SUFFIX;
+}
+
+bool DiskCache::lookup(const std::string &key, std::string* value)
+{
+    if(!m_open || !value)
+        return false;
+    std::string path = entry_path(key);
+    MappedFile file(path);
+    if(!file.is_open())
+        return false;
+    const char* data = file.data();
+    size_t header_size = ENTRY_MAGIC_SIZE+sizeof(uint32_t);
+    if(file.size() < header_size || memcmp(data, ENTRY_MAGIC, ENTRY_MAGIC_SIZE))
+        return false;
+    uint32_t key_size = 0;
+    memcpy(&key_size, data+ENTRY_MAGIC_SIZE, sizeof(uint32_t));
+    if(file.size() < header_size+key_size || key_size != key.size() ||
+            memcmp(data+header_size, key.data(), key_size))
+    {
+        return false; // hash collision
+    }
+    value->assign(data+header_size+key_size, file.size()-header_size-key_size);
+    utimes(path.c_str(), NULL); // mark as recently used
+    return true;
+}
+
+bool DiskCache::store(const std::string &key, const std::string &value)
+{
+    if(!m_open)
+        return false;
+    std::stringstream ss;
+    ss << m_dir << "/" TEMP_PREFIX << getpid() << "." << m_temp_count++;
+    std::string temp_path = ss.str();
+    int fd = open(temp_path.c_str(), O_WRONLY|O_CREAT|O_EXCL, 0666);
+    if(fd == -1)
+        return false;
+    uint32_t key_size = key.size();
+    std::string entry;
+    entry.reserve(ENTRY_MAGIC_SIZE+sizeof(uint32_t)+key.size()+value.size());
+    entry.append(ENTRY_MAGIC, ENTRY_MAGIC_SIZE);
+    entry.append(reinterpret_cast<const char*>(&key_size), sizeof(uint32_t));
+    entry.append(key);
+    entry.append(value);
+    size_t n = 0;
+    while(n < entry.size())
+    {
+        ssize_t k = write(fd, entry.data()+n, entry.size()-n);
+        if(k == -1 && errno == EINTR)
+            continue;
+        if(k <= 0)
+            break;
+        n += k;
+    }
+    close(fd);
+    // readers see either the old entry or the whole new one
+    if(n != entry.size() || rename(temp_path.c_str(), entry_path(key).c_str()) == -1)
+    {
+        unlink(temp_path.c_str());
+        return false;
+    }
+    if(m_max_size_bytes && (m_size_bytes += entry.size()) > m_max_size_bytes)
+        evict();
+    return true;
+}
+
+// recounts the directory, since other processes write to it too, and drops
+// the entries used least recently until it is back under the cap; temporary
+// files no writer has touched for TEMP_MAX_AGE are removed along the way
+void DiskCache::evict()
+{
+    std::lock_guard<std::mutex> lock(m_evict_mutex);
+    DIR* dir = opendir(m_dir.c_str());
+    if(!dir)
+        return;
+    struct entry_t
+    {
+        time_t      m_mtime;
+        size_t      m_size;
+        std::string m_name;
+    };
+    std::vector<entry_t> entries;
+    size_t size_bytes = 0;
+    std::string suffix = ENTRY_SUFFIX;
+    std::string temp_prefix = TEMP_PREFIX;
+    time_t now = time(NULL);
+    while(struct dirent* e = readdir(dir))
+    {
+        std::string name = e->d_name;
+        std::string path = m_dir + "/" + name;
+        if(!name.compare(0, temp_prefix.size(), temp_prefix))
+        {
+            struct stat st;
+            if(stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) && st.st_mtime+TEMP_MAX_AGE < now)
+                unlink(path.c_str());
+            continue;
+        }
+        if(name.size() <= suffix.size() || name.compare(name.size()-suffix.size(), suffix.size(), suffix))
+            continue;
+        struct stat st;
+        if(stat(path.c_str(), &st) == -1 || !S_ISREG(st.st_mode))
+            continue;
+        entries.push_back(entry_t{st.st_mtime, static_cast<size_t>(st.st_size), name});
+        size_bytes += st.st_size;
+    }
+    closedir(dir);
+    if(size_bytes > m_max_size_bytes)
+    {
+        std::sort(entries.begin(), entries.end(),
+                [](const entry_t &x, const entry_t &y) { return x.m_mtime < y.m_mtime; });
+        size_t low_size_bytes = m_max_size_bytes/100*EVICT_LOW_PERCENT;
+        for(auto p = entries.begin(); p != entries.end() && size_bytes > low_size_bytes; p++)
+        {
+            if(unlink((m_dir + "/" + (*p).m_name).c_str()) == 0 || errno == ENOENT)
+                size_bytes -= (*p).m_size; // gone either way
+        }
+    }
+    m_size_bytes = size_bytes;
+}
+
+}
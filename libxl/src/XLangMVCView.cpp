@@ -18,61 +18,101 @@
 #include "mvc/XLangMVCView.h" // mvc::MVCView
 #include "node/XLangNodeIFace.h" // node::NodeIdentIFace
 #include "visitor/XLangPrinter.h" // visitor::LispPrinter
+#include "XLangBinary.h" // binary::write_tree
 #include "XLangType.h" // uint32_t
-#include <string.h> // strlen
 #include <string> // std::string
-#include <iostream> // std::cout
+#include <iostream> // std::ostream
 #include <sstream> // std::stringstream
+#include <vector> // std::vector
 
 /* source code courtesy of Frank Thomas Braun */
 /* minimally altered by onlyuser <mailto:onlyuser@gmail.com> */
 
 /* calc3d.c: Generation of the graph of the syntax tree */
 
-#include <stdio.h> // printf
-#include <string> // strcpy
-
-//#include "calc3.h"
-//#include "calc3.tab.h"
+#include <stdio.h> // snprintf
 
 #define typeId node::NodeIdentIFace::IDENT
 #define typeOpr node::NodeIdentIFace::SYMBOL
 
 namespace xl { namespace mvc {
 
-void MVCView::annotate_tree(
+void MVCView::annotate_tree(node::NodeIdentIFace* _node)
+{
+    if(!_node || _node->height() >= 0)
+        return; // already annotated
+    // one pass in BFS order assigns bfs_index and depth, then a reverse sweep
+    // over the same queue assigns height (children always follow parents)
+    std::vector<node::NodeIdentIFace*> queue;
+    queue.push_back(_node);
+    _node->set_depth(0);
+    for(size_t i = 0; i<queue.size(); i++)
+    {
+        node::NodeIdentIFace* cur = queue[i];
+        if(!cur)
+            continue;
+        cur->set_bfs_index(i);
+        if(cur->type() != node::NodeIdentIFace::SYMBOL)
+            continue;
+        auto symbol = dynamic_cast<node::SymbolNodeIFace*>(cur);
+        for(size_t j = 0; j<symbol->size(); j++)
+        {
+            node::NodeIdentIFace* child = (*symbol)[j];
+            if(child)
+                child->set_depth(cur->depth()+1);
+            queue.push_back(child);
+        }
+    }
+    for(size_t i = queue.size(); i-- > 0;)
+    {
+        node::NodeIdentIFace* cur = queue[i];
+        if(!cur)
+            continue;
+        if(cur->type() != node::NodeIdentIFace::SYMBOL)
+        {
+            cur->set_height(0);
+            continue;
+        }
+        auto symbol = dynamic_cast<node::SymbolNodeIFace*>(cur);
+        int max_height = 0;
+        for(size_t j = 0; j<symbol->size(); j++)
+        {
+            const node::NodeIdentIFace* child = (*symbol)[j];
+            if(child && child->height() > max_height)
+                max_height = child->height();
+        }
+        cur->set_height(max_height+1);
+    }
+}
+
+void MVCView::print_lisp(
         const node::NodeIdentIFace*      _node,
-        visitor::Filterable::filter_cb_t filter_cb)
+        visitor::Filterable::filter_cb_t filter_cb,
+        std::ostream                     &os)
 {
-    visitor::TreeAnnotator v;
+    visitor::LispPrinter v(os);
     if(filter_cb)
         v.set_filter_cb(filter_cb);
     v.dispatch_visit(_node);
-    auto symbol = dynamic_cast<const node::SymbolNodeIFace*>(_node);
-    if(!symbol)
-        return;
-    visitor::TreeAnnotatorBFS v_bfs;
-    if(filter_cb)
-        v_bfs.set_filter_cb(filter_cb);
-    if(v_bfs.visit_next_child(symbol))
-        while(v_bfs.visit_next_child());
 }
 
-void MVCView::print_lisp(
+void MVCView::print_xml(
         const node::NodeIdentIFace*      _node,
-        visitor::Filterable::filter_cb_t filter_cb)
+        visitor::Filterable::filter_cb_t filter_cb,
+        std::ostream                     &os)
 {
-    visitor::LispPrinter v;
+    visitor::XMLPrinter v(os);
     if(filter_cb)
         v.set_filter_cb(filter_cb);
     v.dispatch_visit(_node);
 }
 
-void MVCView::print_xml(
+void MVCView::print_json(
         const node::NodeIdentIFace*      _node,
-        visitor::Filterable::filter_cb_t filter_cb)
+        visitor::Filterable::filter_cb_t filter_cb,
+        std::ostream                     &os)
 {
-    visitor::XMLPrinter v;
+    visitor::JsonPrinter v(os);
     if(filter_cb)
         v.set_filter_cb(filter_cb);
     v.dispatch_visit(_node);
@@ -81,53 +121,70 @@ void MVCView::print_xml(
 void MVCView::print_dot(
         const node::NodeIdentIFace* _node,
         bool                        horizontal,
-        bool                        print_digraph_block)
+        bool                        print_digraph_block,
+        std::ostream                &os)
 {
-    visitor::DotPrinter v(horizontal, print_digraph_block);
+    visitor::DotPrinter v(os, horizontal, print_digraph_block);
     v.dispatch_visit(_node);
 }
 
-void MVCView::print_dot_header(bool horizontal)
+void MVCView::print_dot_header(bool horizontal, std::ostream &os)
 {
-    visitor::DotPrinter::print_header(horizontal);
+    visitor::DotPrinter::print_header(os, horizontal);
 }
 
-void MVCView::print_dot_footer()
+void MVCView::print_dot_footer(std::ostream &os)
 {
-    visitor::DotPrinter::print_footer();
+    visitor::DotPrinter::print_footer(os);
 }
 
-typedef const node::NodeIdentIFace nodeType;
-int ex (nodeType *p);
-void MVCView::print_graph(nodeType* p)
+void MVCView::print_binary(
+        const node::NodeIdentIFace* _node,
+        std::ostream                &os)
 {
-    ex (p);
-    std::cout << std::endl;
+    binary::write_tree(os, _node);
 }
 
-int del = 1; /* distance of graph columns */
-int eps = 3; /* distance of graph lines */
+typedef const node::NodeIdentIFace nodeType;
+
+/* drawing surface, grown on demand (one per call, so rendering is reentrant) */
+struct graph_canvas_t
+{
+    std::vector<std::string> m_lines;
+
+    void put(int l, int c, char x)
+    {
+        if(l >= static_cast<int>(m_lines.size()))
+            m_lines.resize(l+1);
+        std::string &line = m_lines[l];
+        if(c >= static_cast<int>(line.size()))
+            line.resize(c+1, ' ');
+        line[c] = x;
+    }
+};
+
+static const int del = 1; /* distance of graph columns */
+static const int eps = 3; /* distance of graph lines */
 
 /* interface for drawing (can be replaced by "real" graphic using GD or other) */
-void graphInit (void);
-void graphFinish();
-void graphBox (char *s, int *w, int *h);
-void graphDrawBox (char *s, int c, int l);
-void graphDrawArrow (int c1, int l1, int c2, int l2);
+static void graphFinish(graph_canvas_t &graph, std::ostream &os, int graph_number);
+static void graphBox(const std::string &s, int *w, int *h);
+static void graphDrawBox(graph_canvas_t &graph, const std::string &s, int c, int l);
+static void graphDrawArrow(graph_canvas_t &graph, int c1, int l1, int c2, int l2);
 
 /* recursive drawing of the syntax tree */
-void exNode (nodeType *p, int c, int l, int *ce, int *cm);
+static void exNode(graph_canvas_t &graph, nodeType *p, int c, int l, int *ce, int *cm);
 
 /*****************************************************************************/
 
 /* main entry point of the manipulation of the syntax tree */
-int ex (nodeType *p) {
+void MVCView::print_graph(nodeType* p, std::ostream &os, int graph_number)
+{
+    graph_canvas_t graph;
     int rte, rtm;
-
-    graphInit ();
-    exNode (p, 0, 0, &rte, &rtm);
-    graphFinish();
-    return 0;
+    exNode(graph, p, 0, 0, &rte, &rtm);
+    graphFinish(graph, os, graph_number);
+    os << '\n';
 }
 
 /*c----cm---ce---->                       drawing of term-nodes
@@ -146,41 +203,41 @@ int ex (nodeType *p) {
  *
  */
 
-void exNode
-    (   nodeType *p,
+static void exNode
+    (   graph_canvas_t &graph,
+        nodeType *p,
         int c, int l,        /* start column and line of node */
         int *ce, int *cm     /* resulting end column and mid of node */
     )
 {
     int w, h;           /* node width and height */
-    char *s;            /* node text */
+    std::string s;      /* node text */
     int cbar;           /* "real" start column of node (centred above subnodes) */
-    uint32_t k;              /* child number */
+    uint32_t k;         /* child number */
     int che, chm;       /* end column and mid of children */
     int cs;             /* start column of children */
-    char word[20];      /* extended node text */
+    char word[64];      /* formatted number */
 
     if(!p) return;
 
-    strcpy (word, "???"); /* should never appear */
-    s = word;
-    std::string temp;
+    s = "???"; /* should never appear */
     switch(p->type()) {
         case node::NodeIdentIFace::INT:
-            sprintf(word, "%ld", dynamic_cast<const node::TermNodeIFace<node::NodeIdentIFace::INT>*>(p)->value());
+            snprintf(word, sizeof(word), "%ld", dynamic_cast<const node::TermNodeIFace<node::NodeIdentIFace::INT>*>(p)->value());
+            s = word;
             break;
         case node::NodeIdentIFace::FLOAT:
-            sprintf(word, "%f", dynamic_cast<const node::TermNodeIFace<node::NodeIdentIFace::FLOAT>*>(p)->value());
+            snprintf(word, sizeof(word), "%f", dynamic_cast<const node::TermNodeIFace<node::NodeIdentIFace::FLOAT>*>(p)->value());
+            s = word;
             break;
         case node::NodeIdentIFace::STRING:
-            sprintf(word, "\"%s\"", dynamic_cast<const node::TermNodeIFace<node::NodeIdentIFace::STRING>*>(p)->value()->c_str());
+            s = "\"" + *dynamic_cast<const node::TermNodeIFace<node::NodeIdentIFace::STRING>*>(p)->value() + "\"";
             break;
         case typeId:
-            sprintf(word, "%s", dynamic_cast<const node::TermNodeIFace<node::NodeIdentIFace::IDENT>*>(p)->value()->c_str());
+            s = *dynamic_cast<const node::TermNodeIFace<node::NodeIdentIFace::IDENT>*>(p)->value();
             break;
         case typeOpr:
-            temp = p->name();
-            s = const_cast<char*>(temp.c_str());
+            s = p->name();
             break;
         default:
             break;
@@ -193,16 +250,24 @@ void exNode
     *cm = c + w / 2;
 
     /* node is term */
-    if(p->type() != typeOpr ||
-            dynamic_cast<const node::SymbolNodeIFace*>(p)->size() == 0) {
-        graphDrawBox (s, cbar, l);
+    auto symbol = dynamic_cast<const node::SymbolNodeIFace*>(p);
+    if(p->type() != typeOpr || symbol->size() == 0) {
+        graphDrawBox (graph, s, cbar, l);
         return;
     }
 
-    /* node has children */
+    /* node has children (mid columns are kept for the arrows, so each child
+     * is laid out and drawn exactly once) */
+    std::vector<int> child_mids;
+    child_mids.reserve(symbol->size());
     cs = c;
-    for(k = 0; k < dynamic_cast<const node::SymbolNodeIFace*>(p)->size(); k++) {
-        exNode (dynamic_cast<const node::SymbolNodeIFace*>(p)->operator[](k), cs, l+h+eps, &che, &chm);
+    che = c;
+    for(k = 0; k < symbol->size(); k++) {
+        nodeType* child = (*symbol)[k];
+        if(!child)
+            continue;
+        exNode (graph, child, cs, l+h+eps, &che, &chm);
+        child_mids.push_back(chm);
         cs = che;
     }
 
@@ -214,83 +279,49 @@ void exNode
     }
 
     /* draw node */
-    graphDrawBox (s, cbar, l);
+    graphDrawBox (graph, s, cbar, l);
 
-    /* draw arrows (not optimal: children are drawn a second time) */
-    cs = c;
-    for(k = 0; k < dynamic_cast<const node::SymbolNodeIFace*>(p)->size(); k++) {
-        exNode (dynamic_cast<const node::SymbolNodeIFace*>(p)->operator[](k), cs, l+h+eps, &che, &chm);
-        graphDrawArrow (*cm, l+h, chm, l+h+eps-1);
-        cs = che;
-    }
+    /* draw arrows */
+    for(k = 0; k < child_mids.size(); k++)
+        graphDrawArrow (graph, *cm, l+h, child_mids[k], l+h+eps-1);
 }
 
 /* interface for drawing */
 
-#define lmax 200
-#define cmax 200
-
-char graph[lmax][cmax]; /* array for ASCII-Graphic */
-int graphNumber = 0;
-
-void graphTest (int l, int c)
-{   int ok;
-    ok = 1;
-    if(l < 0) ok = 0;
-    if(l >= lmax) ok = 0;
-    if(c < 0) ok = 0;
-    if(c >= cmax) ok = 0;
-    if(ok) return;
-    printf ("\n+++error: l=%d, c=%d not in drawing rectangle 0, 0 ... %d, %d",
-        l, c, lmax, cmax);
-    //exit (1);
-}
-
-void graphInit (void) {
-    int i, j;
-    for(i = 0; i < lmax; i++) {
-        for(j = 0; j < cmax; j++) {
-            graph[i][j] = ' ';
-        }
-    }
-}
-
-void graphFinish() {
-    int i, j;
-    for(i = 0; i < lmax; i++) {
-        for(j = cmax-1; j > 0 && graph[i][j] == ' '; j--);
-        graph[i][cmax-1] = 0;
-        if(j < cmax-1) graph[i][j+1] = 0;
-        if(graph[i][j] == ' ') graph[i][j] = 0;
+static void graphFinish(graph_canvas_t &graph, std::ostream &os, int graph_number) {
+    std::vector<std::string> &lines = graph.m_lines;
+    int last = 0;
+    for(int i = 0; i < static_cast<int>(lines.size()); i++) {
+        size_t n = lines[i].find_last_not_of(' ');
+        lines[i].resize(n == std::string::npos ? 0 : n+1);
+        if(!lines[i].empty())
+            last = i;
     }
-    for(i = lmax-1; i > 0 && graph[i][0] == 0; i--);
-    printf ("\n\nGraph %d:\n", graphNumber++);
-    for(j = 0; j <= i; j++) printf ("\n%s", graph[j]);
-    printf("\n");
+    if(lines.empty())
+        lines.resize(1);
+    os << "\n\nGraph " << graph_number << ":\n";
+    for(int j = 0; j <= last; j++) os << '\n' << lines[j];
+    os << '\n';
 }
 
-void graphBox (char *s, int *w, int *h) {
-    *w = strlen (s) + del;
+static void graphBox(const std::string &s, int *w, int *h) {
+    *w = s.size() + del;
     *h = 1;
 }
 
-void graphDrawBox (char *s, int c, int l) {
-    size_t i;
-    graphTest (l, c+strlen(s)-1+del);
-    for(i = 0; i < strlen (s); i++) {
-        graph[l][c+i+del] = s[i];
+static void graphDrawBox(graph_canvas_t &graph, const std::string &s, int c, int l) {
+    for(size_t i = 0; i < s.size(); i++) {
+        graph.put(l, c+i+del, s[i]);
     }
 }
 
-void graphDrawArrow (int c1, int l1, int c2, int l2) {
+static void graphDrawArrow(graph_canvas_t &graph, int c1, int l1, int c2, int l2) {
     int m;
-    graphTest (l1, c1);
-    graphTest (l2, c2);
     m = (l1 + l2) / 2;
-    while(l1 != m) { graph[l1][c1] = '|'; if(l1 < l2) l1++; else l1--; }
-    while(c1 != c2) { graph[l1][c1] = '-'; if(c1 < c2) c1++; else c1--; }
-    while(l1 != l2) { graph[l1][c1] = '|'; if(l1 < l2) l1++; else l1--; }
-    graph[l1][c1] = '|';
+    while(l1 != m) { graph.put(l1, c1, '|'); if(l1 < l2) l1++; else l1--; }
+    while(c1 != c2) { graph.put(l1, c1, '-'); if(c1 < c2) c1++; else c1--; }
+    while(l1 != l2) { graph.put(l1, c1, '|'); if(l1 < l2) l1++; else l1--; }
+    graph.put(l1, c1, '|');
 }
 
 } }
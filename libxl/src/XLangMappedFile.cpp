@@ -0,0 +1,56 @@
+// XLang
+// -- A parser framework for language modeling
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "XLangMappedFile.h" // xl::MappedFile
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+#include <fcntl.h> // open
+#include <unistd.h> // close
+
+namespace xl {
+
+bool MappedFile::open(std::string filename)
+{
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd == -1)
+        return false;
+    struct stat st;
+    if(fstat(fd, &st) == -1 || !st.st_size)
+    {
+        ::close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // mapping stays valid
+    if(data == MAP_FAILED)
+        return false;
+    m_data = static_cast<const char*>(data);
+    m_size = st.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(!m_data)
+        return;
+    munmap(const_cast<char*>(m_data), m_size);
+    m_data = NULL;
+    m_size = 0;
+}
+
+}
@@ -21,6 +21,7 @@
 #include <sstream> // std::stringstream
 #include <vector> // std::vector
 #include <algorithm> // std::replace, std::find_if
+#include <string.h> // memcpy
 
 // prototype
 extern std::string id_to_name(uint32_t lexer_id);
@@ -88,69 +89,32 @@ bool TermNode<NodeIdentIFace::STRING>::compare(const NodeIdentIFace* _node) cons
     return *m_value == *dynamic_cast<const TermNode<NodeIdentIFace::STRING>*>(_node)->value();
 }
 
-SymbolNode::SymbolNode(uint32_t _lexer_id, size_t _size, va_list ap)
-    : Node(NodeIdentIFace::SYMBOL, _lexer_id)
+SymbolNode::SymbolNode(TreeContext* tc, uint32_t _lexer_id, size_t _size, va_list ap)
+    : Node(NodeIdentIFace::SYMBOL, _lexer_id), m_alloc(&tc->alloc()), m_size(0),
+      m_capacity(INLINE_CHILD_COUNT)
 {
     for(size_t i = 0; i<_size; i++)
-    {
-        NodeIdentIFace* child = va_arg(ap, NodeIdentIFace*);
-        if(child == SymbolNode::eol())
-            continue;
-        if(child && is_same_type(child))
-        {
-            SymbolNode* child_symbol = dynamic_cast<SymbolNode*>(child);
-            m_child_vec.insert(m_child_vec.end(),
-                    child_symbol->m_child_vec.begin(),
-                    child_symbol->m_child_vec.end());
-            for(auto p = child_symbol->m_child_vec.begin(); p != child_symbol->m_child_vec.end(); ++p)
-            {
-                if(*p)
-                    (*p)->set_parent(this);
-            }
-            continue;
-        }
-        m_child_vec.push_back(child);
-        if(child)
-            child->set_parent(this);
-    }
+        append_child(va_arg(ap, NodeIdentIFace*));
 }
 
-SymbolNode::SymbolNode(uint32_t _lexer_id, std::vector<NodeIdentIFace*>& vec)
-    : Node(NodeIdentIFace::SYMBOL, _lexer_id)
+SymbolNode::SymbolNode(TreeContext* tc, uint32_t _lexer_id, std::vector<NodeIdentIFace*>& vec)
+    : Node(NodeIdentIFace::SYMBOL, _lexer_id), m_alloc(&tc->alloc()), m_size(0),
+      m_capacity(INLINE_CHILD_COUNT)
 {
     for(auto q = vec.begin(); q != vec.end(); q++)
-    {
-        NodeIdentIFace* child = *q;
-        if(child == SymbolNode::eol())
-            continue;
-        if(child && is_same_type(child))
-        {
-            SymbolNode* child_symbol = dynamic_cast<SymbolNode*>(child);
-            m_child_vec.insert(m_child_vec.end(),
-                    child_symbol->m_child_vec.begin(),
-                    child_symbol->m_child_vec.end());
-            for(auto p = child_symbol->m_child_vec.begin(); p != child_symbol->m_child_vec.end(); ++p)
-            {
-                if(*p)
-                    (*p)->set_parent(this);
-            }
-            continue;
-        }
-        m_child_vec.push_back(child);
-        if(child)
-            child->set_parent(this);
-    }
+        append_child(*q);
 }
 
 NodeIdentIFace* SymbolNode::clone(TreeContext* tc) const
 {
     va_list ap;
     SymbolNodeIFace *_clone = new (PNEW(tc->alloc(), , NodeIdentIFace))
-            SymbolNode(m_lexer_id, 0, ap);
+            SymbolNode(tc, m_lexer_id, 0, ap);
     _clone->set_original(this);
-    for(auto p = m_child_vec.begin(); p != m_child_vec.end(); ++p)
+    NodeIdentIFace* const* _child_arr = child_arr();
+    for(size_t i = 0; i<m_size; i++)
     {
-        NodeIdentIFace *child_clone = (*p) ? (*p)->clone(tc) : NULL;
+        NodeIdentIFace *child_clone = _child_arr[i] ? _child_arr[i]->clone(tc) : NULL;
         _clone->push_back(child_clone);
         if(child_clone)
             child_clone->set_parent(_clone);
@@ -160,44 +124,46 @@ NodeIdentIFace* SymbolNode::clone(TreeContext* tc) const
 
 void SymbolNode::push_back(NodeIdentIFace* _node)
 {
-    m_child_vec.push_back(_node);
+    insert_at(m_size, _node);
     if(_node)
         _node->set_parent(this);
 }
 
 void SymbolNode::push_front(NodeIdentIFace* _node)
 {
-    m_child_vec.insert(m_child_vec.begin(), _node);
+    insert_at(0, _node);
     if(_node)
         _node->set_parent(this);
 }
 
 void SymbolNode::insert_after(NodeIdentIFace* insert_after_node, NodeIdentIFace* new_node)
 {
-    auto p = std::find(m_child_vec.begin(), m_child_vec.end(), insert_after_node);
-    if(p == m_child_vec.end())
+    NodeIdentIFace** _child_arr = child_arr();
+    auto p = std::find(_child_arr, _child_arr+m_size, insert_after_node);
+    if(p == _child_arr+m_size)
         return;
-    p++;
-    m_child_vec.insert(p, new_node);
+    insert_at(std::distance(_child_arr, p)+1, new_node);
     new_node->set_parent(this);
 }
 
 void SymbolNode::remove_first(NodeIdentIFace* _node)
 {
-    auto p = std::find(m_child_vec.begin(), m_child_vec.end(), _node);
-    if(p == m_child_vec.end())
+    NodeIdentIFace** _child_arr = child_arr();
+    auto p = std::find(_child_arr, _child_arr+m_size, _node);
+    if(p == _child_arr+m_size)
         return;
-    m_child_vec.erase(std::remove(p, m_child_vec.end(), _node), m_child_vec.end());
+    m_size = std::distance(_child_arr, std::remove(p, _child_arr+m_size, _node));
     if(_node)
         _node->set_parent(NULL);
 }
 
 void SymbolNode::replace_first(NodeIdentIFace* find_node, NodeIdentIFace* replacement_node)
 {
-    auto p = std::find(m_child_vec.begin(), m_child_vec.end(), find_node);
-    if(p == m_child_vec.end())
+    NodeIdentIFace** _child_arr = child_arr();
+    auto p = std::find(_child_arr, _child_arr+m_size, find_node);
+    if(p == _child_arr+m_size)
         return;
-    std::replace(p, m_child_vec.end(), find_node, replacement_node);
+    std::replace(p, _child_arr+m_size, find_node, replacement_node);
     if(find_node)
         find_node->set_parent(NULL);
     if(replacement_node)
@@ -206,25 +172,69 @@ void SymbolNode::replace_first(NodeIdentIFace* find_node, NodeIdentIFace* replac
 
 void SymbolNode::erase(int index)
 {
-    if(index<0 || index >= static_cast<int>(m_child_vec.size()))
-        return;
-    auto p = m_child_vec.begin()+index;
-    if(p == m_child_vec.end())
+    if(index<0 || index >= static_cast<int>(m_size))
         return;
-    if(*p)
-        (*p)->set_parent(NULL);
-    m_child_vec.erase(p);
+    NodeIdentIFace** _child_arr = child_arr();
+    if(_child_arr[index])
+        _child_arr[index]->set_parent(NULL);
+    memmove(&_child_arr[index], &_child_arr[index+1], (m_size-index-1)*sizeof(NodeIdentIFace*));
+    m_size--;
 }
 
 NodeIdentIFace* SymbolNode::find_if(bool (*pred)(const NodeIdentIFace* _node)) const
 {
     if(!pred)
         return NULL;
-    auto p = std::find_if(m_child_vec.begin(), m_child_vec.end(), pred);
-    if(p == m_child_vec.end())
+    NodeIdentIFace* const* _child_arr = child_arr();
+    auto p = std::find_if(_child_arr, _child_arr+m_size, pred);
+    if(p == _child_arr+m_size)
         return NULL;
-    int index = std::distance(m_child_vec.begin(), p);
-    return m_child_vec[index];
+    return *p;
+}
+
+void SymbolNode::reserve(size_t capacity)
+{
+    if(capacity <= m_capacity)
+        return;
+    size_t new_capacity = std::max(capacity, static_cast<size_t>(m_capacity)*2);
+    NodeIdentIFace** new_child_arr = reinterpret_cast<NodeIdentIFace**>(
+            m_alloc->_malloc(new_capacity*sizeof(NodeIdentIFace*), __FILE__, __LINE__));
+    memcpy(new_child_arr, child_arr(), m_size*sizeof(NodeIdentIFace*));
+    if(m_capacity > INLINE_CHILD_COUNT)
+        m_alloc->_free(m_spill_child_arr);
+    m_spill_child_arr = new_child_arr;
+    m_capacity = new_capacity;
+}
+
+void SymbolNode::insert_at(size_t index, NodeIdentIFace* _node)
+{
+    reserve(m_size+1);
+    NodeIdentIFace** _child_arr = child_arr();
+    memmove(&_child_arr[index+1], &_child_arr[index], (m_size-index)*sizeof(NodeIdentIFace*));
+    _child_arr[index] = _node;
+    m_size++;
+}
+
+void SymbolNode::append_child(NodeIdentIFace* child)
+{
+    if(child == SymbolNode::eol())
+        return;
+    if(child && is_same_type(child))
+    {
+        SymbolNode* child_symbol = dynamic_cast<SymbolNode*>(child);
+        reserve(m_size+child_symbol->m_size);
+        NodeIdentIFace* const* grandchild_arr = child_symbol->child_arr();
+        for(size_t i = 0; i<child_symbol->m_size; i++)
+        {
+            child_arr()[m_size++] = grandchild_arr[i];
+            if(grandchild_arr[i])
+                grandchild_arr[i]->set_parent(this);
+        }
+        return;
+    }
+    insert_at(m_size, child);
+    if(child)
+        child->set_parent(this);
 }
 
 } }
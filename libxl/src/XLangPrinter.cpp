@@ -17,294 +17,308 @@
 
 #include "visitor/XLangPrinter.h" // visitor::LispPrinter
 #include "XLangString.h" // xl::escape
-#include <iostream> // std::cout
+#include <iostream> // std::ostream
 
 //#define INCLUDE_NODE_UID
 
 namespace xl { namespace visitor {
 
-void TreeAnnotator::visit(const node::SymbolNodeIFace* _node)
-{
-    m_depth++;
-    VisitorDFS::visit(_node);
-    m_depth--;
-    int max_height = 0;
-    for(int i = 0; i < static_cast<int>(_node->size()); i++)
-    {
-        const node::NodeIdentIFace* child = (*_node)[i];
-        if(child->height() > max_height)
-            max_height = child->height();
-    }
-    const_cast<node::SymbolNodeIFace*>(_node)->set_height(max_height+1);
-    const_cast<node::SymbolNodeIFace*>(_node)->set_depth(m_depth);
-}
-
-void TreeAnnotator::visit(const node::TermNodeIFace<node::NodeIdentIFace::INT>* _node)
-{
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::INT>*>(_node)->set_height(0);
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::INT>*>(_node)->set_depth(m_depth);
-}
-
-void TreeAnnotator::visit(const node::TermNodeIFace<node::NodeIdentIFace::FLOAT>* _node)
-{
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::FLOAT>*>(_node)->set_height(0);
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::FLOAT>*>(_node)->set_depth(m_depth);
-}
-
-void TreeAnnotator::visit(const node::TermNodeIFace<node::NodeIdentIFace::STRING>* _node)
-{
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::STRING>*>(_node)->set_height(0);
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::STRING>*>(_node)->set_depth(m_depth);
-}
-
-void TreeAnnotator::visit(const node::TermNodeIFace<node::NodeIdentIFace::CHAR>* _node)
-{
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::CHAR>*>(_node)->set_height(0);
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::CHAR>*>(_node)->set_depth(m_depth);
-}
-
-void TreeAnnotator::visit(const node::TermNodeIFace<node::NodeIdentIFace::IDENT>* _node)
-{
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::IDENT>*>(_node)->set_height(0);
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::IDENT>*>(_node)->set_depth(m_depth);
-}
-
-void TreeAnnotator::visit_null()
-{
-}
-
-void TreeAnnotatorBFS::visit(const node::SymbolNodeIFace* _node)
-{
-    const_cast<node::SymbolNodeIFace*>(_node)->set_bfs_index(m_bfs_index++);
-}
-
-void TreeAnnotatorBFS::visit(const node::TermNodeIFace<node::NodeIdentIFace::INT>* _node)
-{
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::INT>*>(_node)->set_bfs_index(m_bfs_index++);
-}
-
-void TreeAnnotatorBFS::visit(const node::TermNodeIFace<node::NodeIdentIFace::FLOAT>* _node)
-{
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::FLOAT>*>(_node)->set_bfs_index(m_bfs_index++);
-}
-
-void TreeAnnotatorBFS::visit(const node::TermNodeIFace<node::NodeIdentIFace::STRING>* _node)
-{
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::STRING>*>(_node)->set_bfs_index(m_bfs_index++);
-}
-
-void TreeAnnotatorBFS::visit(const node::TermNodeIFace<node::NodeIdentIFace::CHAR>* _node)
-{
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::CHAR>*>(_node)->set_bfs_index(m_bfs_index++);
-}
-
-void TreeAnnotatorBFS::visit(const node::TermNodeIFace<node::NodeIdentIFace::IDENT>* _node)
-{
-    const_cast<node::TermNodeIFace<node::NodeIdentIFace::IDENT>*>(_node)->set_bfs_index(m_bfs_index++);
-}
-
-void TreeAnnotatorBFS::visit_null()
-{
-    m_bfs_index++;
-}
-
 void LispPrinter::visit(const node::SymbolNodeIFace* _node)
 {
-    std::cout << std::string(m_depth*4, ' ') << '(' << _node->name() << std::endl;
+    m_os << std::string(m_depth*4, ' ') << '(' << _node->name() << '\n';
     m_depth++;
     VisitorDFS::visit(_node);
     m_depth--;
-    std::cout << std::string(m_depth*4, ' ') << ')' << std::endl;
+    m_os << std::string(m_depth*4, ' ') << ")\n";
 }
 
 void LispPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::INT>* _node)
 {
-    std::cout << std::string(m_depth*4, ' ');
+    m_os << std::string(m_depth*4, ' ');
     VisitorDFS::visit(_node);
-    std::cout << std::endl;
+    m_os << '\n';
 }
 
 void LispPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::FLOAT>* _node)
 {
-    std::cout << std::string(m_depth*4, ' ');
+    m_os << std::string(m_depth*4, ' ');
     VisitorDFS::visit(_node);
-    std::cout << std::endl;
+    m_os << '\n';
 }
 
 void LispPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::STRING>* _node)
 {
-    std::cout << std::string(m_depth*4, ' ');
+    m_os << std::string(m_depth*4, ' ');
     VisitorDFS::visit(_node);
-    std::cout << std::endl;
+    m_os << '\n';
 }
 
 void LispPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::CHAR>* _node)
 {
-    std::cout << std::string(m_depth*4, ' ');
+    m_os << std::string(m_depth*4, ' ');
     VisitorDFS::visit(_node);
-    std::cout << std::endl;
+    m_os << '\n';
 }
 
 void LispPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::IDENT>* _node)
 {
-    std::cout << std::string(m_depth*4, ' ');
+    m_os << std::string(m_depth*4, ' ');
     VisitorDFS::visit(_node);
-    std::cout << std::endl;
+    m_os << '\n';
 }
 
 void LispPrinter::visit_null()
 {
-    std::cout << std::string(m_depth*4, ' ') << "(NULL)" << std::endl;
+    m_os << std::string(m_depth*4, ' ') << "(NULL)\n";
 }
 
 void XMLPrinter::visit(const node::SymbolNodeIFace* _node)
 {
-    std::cout << std::string(m_depth*4, ' ') << "<symbol ";
+    m_os << std::string(m_depth*4, ' ') << "<symbol ";
     #ifdef INCLUDE_NODE_UID
-        std::cout << "id=" << _node->uid() << " ";
+        m_os << "id=" << _node->uid() << " ";
     #endif
-    std::cout << "type=\"" << _node->name() << "\">" << std::endl;
+    m_os << "type=\"" << _node->name() << "\">\n";
     m_depth++;
     VisitorDFS::visit(_node);
     m_depth--;
-    std::cout << std::string(m_depth*4, ' ') << "</symbol>" << std::endl;
+    m_os << std::string(m_depth*4, ' ') << "</symbol>\n";
 }
 
 void XMLPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::INT>* _node)
 {
-    std::cout << std::string(m_depth*4, ' ') << "<term ";
+    m_os << std::string(m_depth*4, ' ') << "<term ";
     #ifdef INCLUDE_NODE_UID
-        std::cout << "id=" << _node->uid() << " ";
+        m_os << "id=" << _node->uid() << " ";
     #endif
-    std::cout << "type=\"" << _node->name() << "\" value=";
+    m_os << "type=\"" << _node->name() << "\" value=";
     VisitorDFS::visit(_node);
-    std::cout << "/>" << std::endl;
+    m_os << "/>\n";
 }
 
 void XMLPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::FLOAT>* _node)
 {
-    std::cout << std::string(m_depth*4, ' ') << "<term ";
+    m_os << std::string(m_depth*4, ' ') << "<term ";
     #ifdef INCLUDE_NODE_UID
-        std::cout << "id=" << _node->uid() << " ";
+        m_os << "id=" << _node->uid() << " ";
     #endif
-    std::cout << "type=\"" << _node->name() << "\" value=";
+    m_os << "type=\"" << _node->name() << "\" value=";
     VisitorDFS::visit(_node);
-    std::cout << "/>" << std::endl;
+    m_os << "/>\n";
 }
 
 void XMLPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::STRING>* _node)
 {
-    std::cout << std::string(m_depth*4, ' ') << "<term ";
+    m_os << std::string(m_depth*4, ' ') << "<term ";
     #ifdef INCLUDE_NODE_UID
-        std::cout << "id=" << _node->uid() << " ";
+        m_os << "id=" << _node->uid() << " ";
     #endif
-    std::cout << "type=\"" << _node->name() << "\" value=";
-    std::cout << '\"' << xl::escape_xml(*_node->value()) << '\"';
-    std::cout << "/>" << std::endl;
+    m_os << "type=\"" << _node->name() << "\" value=";
+    m_os << '\"' << xl::escape_xml(*_node->value()) << '\"';
+    m_os << "/>\n";
 }
 
 void XMLPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::CHAR>* _node)
 {
-    std::cout << std::string(m_depth*4, ' ') << "<term ";
+    m_os << std::string(m_depth*4, ' ') << "<term ";
     #ifdef INCLUDE_NODE_UID
-        std::cout << "id=" << _node->uid() << " ";
+        m_os << "id=" << _node->uid() << " ";
     #endif
-    std::cout << "type=\"" << _node->name() << "\" value=";
+    m_os << "type=\"" << _node->name() << "\" value=";
     VisitorDFS::visit(_node);
-    std::cout << "/>" << std::endl;
+    m_os << "/>\n";
 }
 
 void XMLPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::IDENT>* _node)
 {
-    std::cout << std::string(m_depth*4, ' ') << "<term ";
+    m_os << std::string(m_depth*4, ' ') << "<term ";
     #ifdef INCLUDE_NODE_UID
-        std::cout << "id=" << _node->uid() << " ";
+        m_os << "id=" << _node->uid() << " ";
     #endif
-    std::cout << "type=\"" << _node->name() << "\" value=";
+    m_os << "type=\"" << _node->name() << "\" value=";
     VisitorDFS::visit(_node);
-    std::cout << "/>" << std::endl;
+    m_os << "/>\n";
 }
 
 void XMLPrinter::visit_null()
 {
-    std::cout << std::string(m_depth*4, ' ') << "<NULL/>" << std::endl;
+    m_os << std::string(m_depth*4, ' ') << "<NULL/>\n";
+}
+
+void JsonPrinter::visit(const node::SymbolNodeIFace* _node)
+{
+    if(m_need_comma)
+        m_os << ',';
+    m_os << "{\"type\":";
+    print_string(m_os, _node->name());
+    m_os << ",\"children\":[";
+    m_need_comma = false;
+    VisitorDFS::visit(_node);
+    m_os << "]}";
+    m_need_comma = true;
+}
+
+void JsonPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::INT>* _node)
+{
+    print_term_prefix(_node);
+    m_os << _node->value() << '}';
+}
+
+void JsonPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::FLOAT>* _node)
+{
+    print_term_prefix(_node);
+    float32_t value = _node->value();
+    if(value != value || value-value != 0) // nan or inf have no json form
+        m_os << "null}";
+    else
+        m_os << value << '}';
+}
+
+void JsonPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::STRING>* _node)
+{
+    print_term_prefix(_node);
+    print_string(m_os, *_node->value());
+    m_os << '}';
+}
+
+void JsonPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::CHAR>* _node)
+{
+    print_term_prefix(_node);
+    print_string(m_os, std::string(1, _node->value()));
+    m_os << '}';
+}
+
+void JsonPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::IDENT>* _node)
+{
+    print_term_prefix(_node);
+    print_string(m_os, *_node->value());
+    m_os << '}';
+}
+
+void JsonPrinter::visit_null()
+{
+    if(m_need_comma)
+        m_os << ',';
+    m_os << "null";
+    m_need_comma = true;
+}
+
+void JsonPrinter::print_term_prefix(const node::NodeIdentIFace* _node)
+{
+    if(m_need_comma)
+        m_os << ',';
+    m_os << "{\"type\":";
+    print_string(m_os, _node->name());
+    m_os << ",\"value\":";
+    m_need_comma = true;
+}
+
+// single pass: unescaped runs are written as-is, in one call each
+void JsonPrinter::print_string(std::ostream &os, const std::string &s)
+{
+    static const char hex[] = "0123456789abcdef";
+    os << '\"';
+    const char* p = s.c_str();
+    const char* run = p;
+    const char* end = p+s.size();
+    for(; p != end; p++)
+    {
+        unsigned char c = *p;
+        if(c >= 0x20 && c != '\"' && c != '\\')
+            continue;
+        os.write(run, p-run);
+        run = p+1;
+        switch(c)
+        {
+            case '\"': os << "\\\""; break;
+            case '\\': os << "\\\\"; break;
+            case '\n': os << "\\n"; break;
+            case '\r': os << "\\r"; break;
+            case '\t': os << "\\t"; break;
+            default:
+                os << "\\u00" << hex[c >> 4] << hex[c & 0xF];
+                break;
+        }
+    }
+    os.write(run, p-run);
+    os << '\"';
 }
 
 void DotPrinter::visit(const node::SymbolNodeIFace* _node)
 {
     if(m_print_digraph_block && _node->is_root())
-        print_header(m_horizontal);
-    std::cout << "\t" << _node->uid() << " [" << std::endl <<
-            "\t\tlabel=\"" << _node->name() << "\"," << std::endl <<
-            "\t\tshape=\"ellipse\"" << std::endl <<
-            "\t];" << std::endl;
+        print_header(m_os, m_horizontal);
+    m_os << "\t" << _node->uid() << " [\n" <<
+            "\t\tlabel=\"" << _node->name() << "\",\n" <<
+            "\t\tshape=\"ellipse\"\n" <<
+            "\t];\n";
     VisitorDFS::visit(_node);
     if(!_node->is_root())
-        std::cout << '\t' << _node->parent()->uid() << "->" << _node->uid() << ";" << std::endl;
+        m_os << '\t' << _node->parent()->uid() << "->" << _node->uid() << ";\n";
     if(m_print_digraph_block && _node->is_root())
-        print_footer();
+        print_footer(m_os);
 }
 
 void DotPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::INT>* _node)
 {
-    std::cout << "\t" << _node->uid() << " [" << std::endl <<
-            "\t\tlabel=\"" << _node->value() << "\"," << std::endl <<
-            "\t\tshape=\"box\"" << std::endl <<
-            "\t];" << std::endl;
-    std::cout << '\t' << _node->parent()->uid() << "->" << _node->uid() << ";" << std::endl;
+    m_os << "\t" << _node->uid() << " [\n" <<
+            "\t\tlabel=\"" << _node->value() << "\",\n" <<
+            "\t\tshape=\"box\"\n" <<
+            "\t];\n";
+    m_os << '\t' << _node->parent()->uid() << "->" << _node->uid() << ";\n";
 }
 
 void DotPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::FLOAT>* _node)
 {
-    std::cout << "\t" << _node->uid() << " [" << std::endl <<
-            "\t\tlabel=\"" << _node->value() << "\"," << std::endl <<
-            "\t\tshape=\"box\"" << std::endl <<
-            "\t];" << std::endl;
-    std::cout << '\t' << _node->parent()->uid() << "->" << _node->uid() << ";" << std::endl;
+    m_os << "\t" << _node->uid() << " [\n" <<
+            "\t\tlabel=\"" << _node->value() << "\",\n" <<
+            "\t\tshape=\"box\"\n" <<
+            "\t];\n";
+    m_os << '\t' << _node->parent()->uid() << "->" << _node->uid() << ";\n";
 }
 
 void DotPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::STRING>* _node)
 {
-    std::cout << "\t" << _node->uid() << " [" << std::endl <<
-            "\t\tlabel=\"" << xl::escape(*_node->value()) << "\"," << std::endl <<
-            "\t\tshape=\"box\"" << std::endl <<
-            "\t];" << std::endl;
-    std::cout << '\t' << _node->parent()->uid() << "->" << _node->uid() << ";" << std::endl;
+    m_os << "\t" << _node->uid() << " [\n" <<
+            "\t\tlabel=\"" << xl::escape(*_node->value()) << "\",\n" <<
+            "\t\tshape=\"box\"\n" <<
+            "\t];\n";
+    m_os << '\t' << _node->parent()->uid() << "->" << _node->uid() << ";\n";
 }
 
 void DotPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::CHAR>* _node)
 {
-    std::cout << "\t" << _node->uid() << " [" << std::endl <<
-            "\t\tlabel=\"" << xl::escape(_node->value()) << "\"," << std::endl <<
-            "\t\tshape=\"box\"" << std::endl <<
-            "\t];" << std::endl;
-    std::cout << '\t' << _node->parent()->uid() << "->" << _node->uid() << ";" << std::endl;
+    m_os << "\t" << _node->uid() << " [\n" <<
+            "\t\tlabel=\"" << xl::escape(_node->value()) << "\",\n" <<
+            "\t\tshape=\"box\"\n" <<
+            "\t];\n";
+    m_os << '\t' << _node->parent()->uid() << "->" << _node->uid() << ";\n";
 }
 
 void DotPrinter::visit(const node::TermNodeIFace<node::NodeIdentIFace::IDENT>* _node)
 {
-    std::cout << "\t" << _node->uid() << " [" << std::endl <<
-            "\t\tlabel=\"" << *_node->value() << "\"," << std::endl <<
-            "\t\tshape=\"box\"" << std::endl <<
-            "\t];" << std::endl;
-    std::cout << '\t' << _node->parent()->uid() << "->" << _node->uid() << ";" << std::endl;
+    m_os << "\t" << _node->uid() << " [\n" <<
+            "\t\tlabel=\"" << *_node->value() << "\",\n" <<
+            "\t\tshape=\"box\"\n" <<
+            "\t];\n";
+    m_os << '\t' << _node->parent()->uid() << "->" << _node->uid() << ";\n";
 }
 
 void DotPrinter::visit_null()
 {
-    std::cout << "/* NULL */";
+    m_os << "/* NULL */";
 }
 
-void DotPrinter::print_header(bool horizontal)
+void DotPrinter::print_header(std::ostream &os, bool horizontal)
 {
-    std::cout << "digraph g {" << std::endl;
+    os << "digraph g {\n";
     if(horizontal)
-        std::cout << "\tgraph [rankdir = \"LR\"];" << std::endl;
+        os << "\tgraph [rankdir = \"LR\"];\n";
 }
 
-void DotPrinter::print_footer()
+void DotPrinter::print_footer(std::ostream &os)
 {
-    std::cout << "}" << std::endl;
+    os << "}\n";
 }
 
 } }
@@ -0,0 +1,102 @@
+// XLang
+// -- A parser framework for language modeling
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "XLangSink.h" // xl::Sink
+#include <string.h> // memcpy
+#include <unistd.h> // write
+#include <errno.h> // errno
+
+namespace xl {
+
+Sink::Sink(size_t buf_size)
+    : m_buf(buf_size ? buf_size : 1)
+{
+    setp(&m_buf[0], &m_buf[0]+m_buf.size());
+}
+
+bool Sink::flush()
+{
+    size_t n = pptr()-pbase();
+    if(!n)
+        return true;
+    bool result = drain(pbase(), n);
+    setp(&m_buf[0], &m_buf[0]+m_buf.size());
+    return result;
+}
+
+Sink::int_type Sink::overflow(int_type c)
+{
+    if(!flush())
+        return traits_type::eof();
+    if(traits_type::eq_int_type(c, traits_type::eof()))
+        return traits_type::not_eof(c);
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+}
+
+std::streamsize Sink::xsputn(const char* s, std::streamsize n)
+{
+    if(n <= epptr()-pptr())
+    {
+        memcpy(pptr(), s, n);
+        pbump(n);
+        return n;
+    }
+    if(!flush())
+        return 0;
+    if(static_cast<size_t>(n) >= m_buf.size())
+        return drain(s, n) ? n : 0; // too big to buffer, bypass
+    memcpy(pptr(), s, n);
+    pbump(n);
+    return n;
+}
+
+int Sink::sync()
+{
+    return flush() ? 0 : -1;
+}
+
+bool FdSink::drain(const char* buf, size_t n)
+{
+    while(n)
+    {
+        ssize_t written = write(m_fd, buf, n);
+        if(written < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            return false;
+        }
+        buf += written;
+        n   -= written;
+    }
+    return true;
+}
+
+bool StringSink::drain(const char* buf, size_t n)
+{
+    m_str.append(buf, n);
+    return true;
+}
+
+bool CallbackSink::drain(const char* buf, size_t n)
+{
+    return m_drain_cb ? m_drain_cb(buf, n, m_context) : false;
+}
+
+}
@@ -42,17 +42,10 @@ bool read_file(std::string filename, std::string &s)
         fclose(file);
         return false;
     }
-    char* buffer = new char[length+1];
-    if(!buffer) {
-        std::cerr << "not enough memory" << std::endl;
-        fclose(file);
-        return false;
-    }
-    buffer[length] = '\0';
-    fread(buffer, 1, length, file);
+    s.resize(length); // read straight into the string, no staging copy
+    size_t n = fread(&s[0], 1, length, file);
     fclose(file);
-    s = buffer;
-    delete[] buffer;
+    s.resize(n);
     return true;
 }
 
@@ -21,7 +21,9 @@
 #include <stdlib.h> // free
 #include <string.h> // strdup
 #include <iostream> // std::cerr
-#include <unistd.h> // getpid
+#include <unistd.h> // getpid, fork, execvp, pipe2
+#include <fcntl.h> // O_CLOEXEC
+#include <errno.h> // errno
 #include <iomanip> // std::setfill
 #include <string> // std::string
 #include <vector> // std::vector
@@ -30,6 +32,7 @@
 #include <ucontext.h> // ucontext_t
 #include <cxxabi.h> // abi::__cxa_demangle
 #include <sys/wait.h> // waitpid
+#include <time.h> // clock_gettime
 #include <bits/signum.h> // SIGSEGV
 
 //#define DEBUG
@@ -75,6 +78,48 @@ std::string shell_capture(std::string cmd)
     return result.substr(0, result.length()-1);
 }
 
+std::string exec_capture(const std::vector<std::string> &args)
+{
+    if(args.empty())
+        return "";
+    std::vector<char*> argv; // built before forking, the child may not allocate
+    for(auto p = args.begin(); p != args.end(); p++)
+        argv.push_back(const_cast<char*>((*p).c_str()));
+    argv.push_back(NULL);
+    int fds[2];
+    if(pipe2(fds, O_CLOEXEC) == -1) // other threads may be forking too
+        return "";
+    pid_t pid = fork();
+    if(pid == -1)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return "";
+    }
+    if(!pid)
+    {
+        dup2(fds[1], STDOUT_FILENO);
+        execvp(argv[0], &argv[0]);
+        _exit(127);
+    }
+    close(fds[1]);
+    char buf[MAX_PIPEBUF_SIZE];
+    std::string result = "";
+    for(;;)
+    {
+        ssize_t n = read(fds[0], buf, sizeof(buf));
+        if(n > 0)
+            result.append(buf, n);
+        else if(n == -1 && errno == EINTR)
+            continue;
+        else
+            break;
+    }
+    close(fds[0]);
+    while(waitpid(pid, NULL, 0) == -1 && errno == EINTR);
+    return result.substr(0, result.length()-1); // drop the last newline, as shell_capture does
+}
+
 std::string get_basename(std::string filename)
 {
     std::string _basename;
@@ -179,4 +224,11 @@ void add_sighandler(int sig, sa_sigaction_t _sa_sigaction)
     sigaction(sig, &sa, NULL);
 }
 
+double monotonic_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
 } }
@@ -0,0 +1,168 @@
+// XLang
+// -- A parser framework for language modeling
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "XLangTrace.h" // xl::trace::Span
+#include "XLangSystem.h" // xl::system::monotonic_seconds
+#include "visitor/XLangPrinter.h" // visitor::JsonPrinter
+#include <vector> // std::vector
+#include <string> // std::string
+#include <fstream> // std::ofstream
+#include <iomanip> // std::setprecision
+#include <mutex> // std::mutex
+#include <atomic> // std::atomic
+#include <algorithm> // std::min
+
+namespace xl { namespace trace {
+
+struct event_t
+{
+    const char* m_name;
+    const char* m_category;
+    double      m_start_us;
+    double      m_duration_us;
+    int         m_arg_count;
+    const char* m_arg_names[MAX_SPAN_ARGS];
+    long        m_arg_values[MAX_SPAN_ARGS];
+};
+
+// events of one thread, allocated up front so recording never allocates;
+// buffers outlive their threads so they can be written at the end
+struct buffer_t
+{
+    std::vector<event_t> m_events;
+    size_t               m_next;
+    size_t               m_recorded;
+    int                  m_tid;
+    std::string          m_thread_name;
+
+    buffer_t(size_t size, int tid)
+        : m_events(size), m_next(0), m_recorded(0), m_tid(tid)
+    {}
+};
+
+static std::atomic<bool>      trace_enabled(false);
+static size_t                 buffer_events = DEFAULT_BUFFER_EVENTS;
+static std::mutex             buffers_mutex;
+static std::vector<buffer_t*> buffers;
+static thread_local buffer_t* thread_buffer = NULL;
+
+static buffer_t* get_thread_buffer()
+{
+    if(!thread_buffer)
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        thread_buffer = new buffer_t(buffer_events, buffers.size()+1);
+        buffers.push_back(thread_buffer);
+    }
+    return thread_buffer;
+}
+
+void enable(size_t _buffer_events)
+{
+    buffer_events = _buffer_events ? _buffer_events : 1;
+    trace_enabled = true;
+}
+
+bool enabled()
+{
+    return trace_enabled.load(std::memory_order_relaxed);
+}
+
+void set_thread_name(const char* name)
+{
+    if(enabled())
+        get_thread_buffer()->m_thread_name = name;
+}
+
+void record(const char* name, const char* category, double start_us, double duration_us,
+        int arg_count, const char* const* arg_names, const long* arg_values)
+{
+    buffer_t* buffer = get_thread_buffer();
+    event_t &event = buffer->m_events[buffer->m_next];
+    event.m_name        = name;
+    event.m_category    = category;
+    event.m_start_us    = start_us;
+    event.m_duration_us = duration_us;
+    event.m_arg_count   = arg_count;
+    for(int i = 0; i<arg_count; i++)
+    {
+        event.m_arg_names[i]  = arg_names[i];
+        event.m_arg_values[i] = arg_values[i];
+    }
+    buffer->m_next = (buffer->m_next+1) % buffer->m_events.size();
+    buffer->m_recorded++;
+}
+
+bool write_json(std::string filename)
+{
+    std::ofstream os(filename.c_str());
+    if(!os)
+        return false;
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl << std::fixed << std::setprecision(3);
+    bool first = true;
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    for(auto p = buffers.begin(); p != buffers.end(); p++)
+    {
+        const buffer_t &buffer = **p;
+        if(buffer.m_thread_name.size())
+        {
+            os << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+               << buffer.m_tid << ",\"args\":{\"name\":";
+            visitor::JsonPrinter::print_string(os, buffer.m_thread_name);
+            os << "}}";
+            first = false;
+        }
+        size_t size = buffer.m_events.size();
+        size_t count = std::min(buffer.m_recorded, size);
+        size_t begin = (buffer.m_recorded > size) ? buffer.m_next : 0; // oldest surviving event
+        for(size_t i = 0; i<count; i++)
+        {
+            const event_t &event = buffer.m_events[(begin+i) % size];
+            os << (first ? "" : ",\n") << "{\"ph\":\"X\",\"name\":\"" << event.m_name
+               << "\",\"cat\":\"" << event.m_category << "\",\"pid\":1,\"tid\":" << buffer.m_tid
+               << ",\"ts\":" << event.m_start_us << ",\"dur\":" << event.m_duration_us;
+            if(event.m_arg_count)
+            {
+                os << ",\"args\":{";
+                for(int j = 0; j<event.m_arg_count; j++)
+                    os << (j ? "," : "") << '"' << event.m_arg_names[j] << "\":" << event.m_arg_values[j];
+                os << '}';
+            }
+            os << '}';
+            first = false;
+        }
+    }
+    os << std::endl << "]}" << std::endl;
+    return static_cast<bool>(os);
+}
+
+Span::Span(const char* name, const char* category)
+    : m_name(name), m_category(category), m_start_us(-1), m_arg_count(0)
+{
+    if(enabled())
+        m_start_us = xl::system::monotonic_seconds()*1e6;
+}
+
+Span::~Span()
+{
+    if(m_start_us < 0)
+        return;
+    record(m_name, m_category, m_start_us, xl::system::monotonic_seconds()*1e6-m_start_us, m_arg_count,
+            m_arg_names, m_arg_values);
+}
+
+} }
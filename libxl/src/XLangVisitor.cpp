@@ -17,7 +17,7 @@
 
 #include "visitor/XLangVisitor.h" // visitor::Visitor
 #include "XLangString.h" // xl::escape
-#include <iostream> // std::cout
+#include <iostream> // std::ostream
 
 //#define DEBUG
 
@@ -25,27 +25,27 @@ namespace xl { namespace visitor {
 
 void Visitor::visit(const node::TermNodeIFace<node::NodeIdentIFace::INT>* _node)
 {
-    std::cout << _node->value();
+    m_os << _node->value();
 }
 void Visitor::visit(const node::TermNodeIFace<node::NodeIdentIFace::FLOAT>* _node)
 {
-    std::cout << _node->value();
+    m_os << _node->value();
 }
 void Visitor::visit(const node::TermNodeIFace<node::NodeIdentIFace::STRING>* _node)
 {
-    std::cout << '\"' << xl::escape(*_node->value()) << '\"';
+    m_os << '\"' << xl::escape(*_node->value()) << '\"';
 }
 void Visitor::visit(const node::TermNodeIFace<node::NodeIdentIFace::CHAR>* _node)
 {
-    std::cout << '\'' << xl::escape(_node->value()) << '\'';
+    m_os << '\'' << xl::escape(_node->value()) << '\'';
 }
 void Visitor::visit(const node::TermNodeIFace<node::NodeIdentIFace::IDENT>* _node)
 {
-    std::cout << *_node->value();
+    m_os << *_node->value();
 }
 void Visitor::visit_null()
 {
-    std::cout << "NULL";
+    m_os << "NULL";
 }
 void Visitor::dispatch_visit(const node::NodeIdentIFace* unknown)
 {
@@ -58,9 +58,9 @@ void Visitor::dispatch_visit(const node::NodeIdentIFace* unknown)
     #ifdef DEBUG
         if(is_printer())
         {
-            std::cout << "{depth=" << unknown->depth()
+            m_os << "{depth=" << unknown->depth()
                       << ", height=" << unknown->height()
-                      << ", bfs_index=" << unknown->bfs_index() << "}" << std::endl;
+                      << ", bfs_index=" << unknown->bfs_index() << "}\n";
         }
     #endif
     switch(unknown->type())
@@ -84,7 +84,7 @@ void Visitor::dispatch_visit(const node::NodeIdentIFace* unknown)
             visit(dynamic_cast<const node::SymbolNodeIFace*>(unknown));
             break;
         default:
-            std::cout << "unknown node type" << std::endl;
+            m_os << "unknown node type\n";
             break;
     }
 }
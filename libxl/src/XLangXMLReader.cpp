@@ -0,0 +1,217 @@
+// XLang
+// -- A parser framework for language modeling
+// Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+#include "XLangXMLReader.h" // xl::XMLReader
+#include <string.h> // strlen
+#include <ctype.h> // isspace
+
+namespace xl {
+
+XMLReader::XMLReader(std::istream &is)
+    : m_sb(is.rdbuf()), m_attr_count(0), m_pending_end(false), m_eof(false), m_line(1)
+{}
+
+XMLReader::event_t XMLReader::next()
+{
+    if(m_pending_end)
+    {
+        m_pending_end = false;
+        m_attr_count = 0;
+        return ELEMENT_END;
+    }
+    if(!m_error.empty())
+        return PARSE_ERROR;
+    for(;;)
+    {
+        int c;
+        do // text content is not part of the format
+        {
+            c = get();
+        } while(c != EOF && c != '<');
+        if(c == EOF)
+        {
+            m_eof = true;
+            return END_OF_INPUT;
+        }
+        c = peek();
+        if(c == '?')
+        {
+            if(!skip_past("?>"))
+                return fail("unterminated declaration");
+            continue;
+        }
+        if(c == '!')
+        {
+            get();
+            if(peek() == '-')
+            {
+                if(!skip_past("-->"))
+                    return fail("unterminated comment");
+            }
+            else if(!skip_past(">"))
+                return fail("unterminated directive");
+            continue;
+        }
+        break;
+    }
+    m_attr_count = 0;
+    if(peek() == '/')
+    {
+        get();
+        if(!read_name(&m_name))
+            return fail("expected element name");
+        skip_space();
+        if(get() != '>')
+            return fail("expected '>'");
+        return ELEMENT_END;
+    }
+    if(!read_name(&m_name))
+        return fail("expected element name");
+    for(;;)
+    {
+        skip_space();
+        int c = peek();
+        if(c == '>')
+        {
+            get();
+            return ELEMENT_BEGIN;
+        }
+        if(c == '/')
+        {
+            get();
+            if(get() != '>')
+                return fail("expected '/>'");
+            m_pending_end = true;
+            return ELEMENT_BEGIN;
+        }
+        if(m_attr_count == m_attrs.size())
+            m_attrs.push_back(attr_t());
+        attr_t &_attr = m_attrs[m_attr_count];
+        if(!read_name(&_attr.first))
+            return fail("expected attribute name");
+        skip_space();
+        if(get() != '=')
+            return fail("expected '='");
+        skip_space();
+        if(!read_value(&_attr.second))
+            return fail("bad attribute value");
+        m_attr_count++;
+        if(m_pending_end)
+            return ELEMENT_BEGIN;
+    }
+}
+
+const std::string* XMLReader::attr(const std::string &key) const
+{
+    for(size_t i = 0; i<m_attr_count; i++)
+    {
+        if(m_attrs[i].first == key)
+            return &m_attrs[i].second;
+    }
+    return NULL;
+}
+
+int XMLReader::peek()
+{
+    int c = m_sb->sgetc();
+    return (c == std::streambuf::traits_type::eof()) ? EOF : c;
+}
+
+int XMLReader::get()
+{
+    int c = m_sb->sbumpc();
+    if(c == std::streambuf::traits_type::eof())
+        return EOF;
+    if(c == '\n')
+        m_line++;
+    return c;
+}
+
+void XMLReader::skip_space()
+{
+    while(peek() != EOF && isspace(peek()))
+        get();
+}
+
+bool XMLReader::skip_past(const char* terminator)
+{
+    size_t n = strlen(terminator);
+    size_t matched = 0;
+    while(matched < n)
+    {
+        int c = get();
+        if(c == EOF)
+            return false;
+        if(c == terminator[matched])
+            matched++;
+        else
+            matched = (c == terminator[0]) ? 1 : 0;
+    }
+    return true;
+}
+
+bool XMLReader::read_name(std::string* s)
+{
+    s->clear();
+    for(int c = peek(); c != EOF && !isspace(c) && c != '=' && c != '/' && c != '>'; c = peek())
+        s->push_back(get());
+    return !s->empty();
+}
+
+bool XMLReader::read_value(std::string* s)
+{
+    s->clear();
+    int c = peek();
+    if(c == '\"' || c == '\'')
+    {
+        int quote = get();
+        for(c = get(); c != quote; c = get())
+        {
+            if(c == EOF)
+                return false;
+            s->push_back(c);
+            if(c == '\\') // keep escape sequence intact for xl::unescape
+            {
+                if((c = get()) == EOF)
+                    return false;
+                s->push_back(c);
+            }
+        }
+        return true;
+    }
+    for(c = peek(); c != EOF && !isspace(c) && c != '>'; c = peek())
+    {
+        get();
+        if(c == '/' && peek() == '>') // value ends the element, as in "value=x/>"
+        {
+            get();
+            m_pending_end = true;
+            break;
+        }
+        s->push_back(c);
+    }
+    return !s->empty();
+}
+
+XMLReader::event_t XMLReader::fail(const char* message)
+{
+    m_error = message;
+    m_pending_end = false;
+    return PARSE_ERROR;
+}
+
+}
@@ -19,7 +19,7 @@
 
 show_help()
 {
-    echo "Usage: `basename $0` <EXEC> <EXEC_FLAGS> <INPUT_MODE={xml|file|stin|arg}> <INPUT_FILE> <OUTPUT_FILE>"
+    echo "Usage: `basename $0` <EXEC> <EXEC_FLAGS> <INPUT_MODE={xml|binary|file|stdin|arg}> <INPUT_FILE> <OUTPUT_FILE>"
 }
 
 if [ $# -ne 5 ]; then
@@ -45,11 +45,14 @@ case $INPUT_MODE in
     "xml")
         $EXEC $EXEC_FLAGS --in-xml $INPUT_FILE | tee $OUTPUT_FILE
         ;;
+    "binary")
+        $EXEC $EXEC_FLAGS --in-binary $INPUT_FILE | tee $OUTPUT_FILE
+        ;;
     "file")
         $EXEC $EXEC_FLAGS --in-file $INPUT_FILE | tee $OUTPUT_FILE
         ;;
     "stdin")
-        cat $INPUT_FILE | $EXEC $EXEC_FLAGS | tee $OUTPUT_FILE
+        cat $INPUT_FILE | $EXEC $EXEC_FLAGS --stdin | tee $OUTPUT_FILE
         ;;
     "arg")
         $EXEC $EXEC_FLAGS --expr "`cat $INPUT_FILE`" | tee $OUTPUT_FILE
@@ -0,0 +1,72 @@
+#!/bin/bash
+
+# NatLang
+# -- An English parser with an extensible grammar
+# Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program. If not, see <http://www.gnu.org/licenses/>.
+show_help()
+{
+    echo "Usage: `basename $0` <EXEC> <INPUT_FILE> <OUTPUT_FILE_STEM>"
+}
+
+if [ $# -ne 3 ]; then
+    echo "fail! -- expect 3 arguments! ==> $@"
+    show_help
+    exit 1
+fi
+
+TEMP_FILE_0=`mktemp`
+TEMP_FILE_1=`mktemp`
+trap "rm $TEMP_FILE_0 $TEMP_FILE_1" EXIT
+
+EXEC=$1
+INPUT_FILE=$2
+OUTPUT_FILE_STEM=$3
+PASS_FILE=${OUTPUT_FILE_STEM}.pass
+FAIL_FILE=${OUTPUT_FILE_STEM}.fail
+
+if [ ! -f $INPUT_FILE ]; then
+    echo "fail! -- INPUT_FILE not found! ==> $INPUT_FILE"
+    exit 1
+fi
+
+# damages a copy of a valid binary file, which must then be rejected without
+# exporting anything
+reject()
+{
+    DAMAGE=$1
+    $EXEC --binary --in-binary $TEMP_FILE_0 > $TEMP_FILE_1
+    if [ $? -eq 0 -o -s $TEMP_FILE_1 ]; then
+        echo "fail! -- $DAMAGE file accepted" | tee -a $FAIL_FILE
+        exit 1
+    fi
+}
+
+rm -f $FAIL_FILE
+
+head -c -8 $INPUT_FILE > $TEMP_FILE_0
+reject "truncated"
+
+cp $INPUT_FILE $TEMP_FILE_0
+printf "Y" | dd of=$TEMP_FILE_0 bs=1 seek=0 conv=notrunc 2> /dev/null
+reject "bad magic"
+
+# the first node record follows the 24-byte header and 8-byte lexer entries
+LEXER_COUNT=`od -An -tu4 -j12 -N4 $INPUT_FILE`
+cp $INPUT_FILE $TEMP_FILE_0
+printf "\x7e" | dd of=$TEMP_FILE_0 bs=1 seek=$((24+8*LEXER_COUNT)) conv=notrunc 2> /dev/null
+reject "bad node type"
+
+echo "success!" | tee $PASS_FILE
@@ -0,0 +1,72 @@
+#!/bin/bash
+
+# NatLang
+# -- An English parser with an extensible grammar
+# Copyright (C) 2011 onlyuser <mailto:onlyuser@gmail.com>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program. If not, see <http://www.gnu.org/licenses/>.
+show_help()
+{
+    echo "Usage: `basename $0` <EXEC> <INPUT_FILE> <OUTPUT_FILE_STEM>"
+}
+
+if [ $# -ne 3 ]; then
+    echo "fail! -- expect 3 arguments! ==> $@"
+    show_help
+    exit 1
+fi
+
+TEMP_FILE_0=`mktemp`
+TEMP_FILE_1=`mktemp`
+trap "rm $TEMP_FILE_0 $TEMP_FILE_1" EXIT
+
+EXEC=$1
+INPUT_FILE=$2
+OUTPUT_FILE_STEM=$3
+PASS_FILE=${OUTPUT_FILE_STEM}.pass
+FAIL_FILE=${OUTPUT_FILE_STEM}.fail
+
+if [ ! -f $INPUT_FILE ]; then
+    echo "fail! -- INPUT_FILE not found! ==> $INPUT_FILE"
+    exit 1
+fi
+
+# the first line of INPUT_FILE is a sentence, and each line after it is an
+# edit and the sentence it leaves, as "EDIT => SENTENCE"; the edits are
+# applied in turn with --reparse, and after each one the output, parse errors
+# included, must be that of a fresh parse of the sentence it leaves
+emit()
+{
+    $EXEC --json "$@" 2>&1 | grep -v "^INFO: "
+}
+
+rm -f $FAIL_FILE
+
+EDIT_FLAGS=()
+while IFS= read -r LINE; do
+    if [ ${#EDIT_FLAGS[@]} -eq 0 -a -z "$SENTENCE" ]; then
+        SENTENCE=$LINE
+        continue
+    fi
+    EDIT_FLAGS+=(--reparse "${LINE%% => *}")
+    emit --expr "$SENTENCE" "${EDIT_FLAGS[@]}" > $TEMP_FILE_0
+    emit --expr "${LINE#* => }" > $TEMP_FILE_1
+    if ! cmp -s $TEMP_FILE_0 $TEMP_FILE_1; then
+        diff $TEMP_FILE_0 $TEMP_FILE_1 | tee $FAIL_FILE
+        echo "fail! -- after \"${LINE%% => *}\"" | tee -a $FAIL_FILE
+        exit 1
+    fi
+done < $INPUT_FILE
+
+echo "success!" | tee $PASS_FILE